@@ -0,0 +1,271 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// BlaTable.h
+
+// bilinear approximation (BLA) for the perturbation engine.  while d is small against
+// Z_m the d^2 term of a step can be dropped,
+//
+//     d_m+1 = 2*Z_m*d_m + dc = A*d_m + B*dc
+//
+// and two such steps compose into one with A = Ay*Ax, B = Ay*Bx + By.  the table holds
+// steps of 1, 2, 4 ... iterations, each with the radius |d| must be under for it to
+// hold, so a pixel can jump a long way down the orbit at any point, not just at the
+// start like the series approximation.
+//
+// the radii depend on the largest |dc| in the frame.  a table built for a larger |dc|
+// still holds (its radii are only smaller than need be) so one is kept while the frames
+// zoom in on the same orbit, until |dc| has shrunk by BLA_REUSE_RATIO.  to stay inside
+// a memory cap the shortest levels are left out, the pixels take plain perturbation
+// steps where nothing longer applies.
+
+#ifndef BLA_TABLE_H
+#define BLA_TABLE_H
+
+#include <vector>
+#include <cmath>
+#include "FloatExp.h"
+#include "ReferenceOrbit.h"
+
+#define BLA_MAX_LEVELS 32
+#define BLA_EPSILON    1.1102230246251565e-16 // 2^-53, d^2 against 2*Z*d
+#define BLA_DEFAULT_CAP (256 * 1024 * 1024)  // bytes
+#define BLA_REUSE_RATIO 2.0 // rebuild once the frame's |dc| is this much smaller
+
+// one step of the table, d' = A*d + B*dc while |d|^2 < r2
+template<typename T>
+struct BlaStep { T ar, ai, br, bi, r2; };
+
+template<typename T>
+class BlaTable
+{
+  public:
+    BlaTable() : m_minLevel(0), m_levels(0), m_bytes(0), m_orbit(NULL), m_generation(0), m_cap(0), m_reused(false) {}
+
+    // build the steps along orbit for a frame whose pixels are at most dcmax from
+    // the reference, in no more than cap bytes.  nothing is done if the table is
+    // already good for it.
+    void build(ReferenceOrbit *orbit, const floatexp dcmax, const size_t cap);
+
+    // the longest step starting at orbit index n that holds for |d|^2 = d2 and is no
+    // more than limit iterations, NULL if there is none
+    inline const BlaStep<T>* lookup(const unsigned int n, const T d2, const unsigned int limit, 
+                                    unsigned int *steps) const
+    {
+        if (n == 0) {
+            return NULL; // Z_0 = 0, nothing to skip
+        }
+        // a step of 2^l iterations starts at every n with n - 1 a multiple of 2^l
+        unsigned int m = n - 1;
+        int top = (m == 0) ? m_levels - 1 : __builtin_ctz(m);
+        if (top > m_levels - 1) {
+            top = m_levels - 1;
+        }
+        for (int l = top; l >= m_minLevel; l--)
+        {
+            unsigned int size = 1u << l;
+            unsigned int k = m >> l;
+            if (size > limit || k >= m_table[l].size()) {
+                continue;
+            }
+            const BlaStep<T> *step = &(m_table[l][k]);
+            if (d2 < step->r2) {
+                *steps = size;
+                return step;
+            }
+        }
+        return NULL;
+    }
+
+    int minLevel() const { return m_minLevel; }
+    int levels() const { return m_levels; }
+    // memory held by the table and its build scratch
+    size_t bytes() const { return m_bytes; }
+    // true if the last build kept the table it already had
+    bool reused() const { return m_reused; }
+
+  private:
+    // a step while it is being built, floatexp so A can grow past a double
+    struct Merge { floatexp ar, ai, br, bi, r; };
+
+    static Merge single(const double Zr, const double Zi);
+    static Merge merge(const Merge &x, const Merge &y, const floatexp &dcmax);
+    static void store(const Merge &x, BlaStep<T> *step);
+    template<typename Orbit>
+    void fold(Orbit &orbit, const floatexp dcmax);
+    size_t capacity_bytes() const;
+
+    int m_minLevel; // shortest level kept, 2^m_minLevel iterations
+    int m_levels;   // levels below this are in the table
+    size_t m_bytes;
+    std::vector<BlaStep<T> > m_table[BLA_MAX_LEVELS];
+    std::vector<Merge> m_prev, m_next; // build scratch
+
+    // what the table was built for
+    ReferenceOrbit *m_orbit;
+    unsigned int m_generation;
+    floatexp m_dcmax;
+    size_t m_cap;
+    bool m_reused;
+};
+
+// ----------------------------------------------------------------------------
+// the plain step at Z, A = 2Z, B = 1, good while |d| < epsilon*|2Z|
+//
+template<typename T>
+typename BlaTable<T>::Merge BlaTable<T>::single(const double Zr, const double Zi)
+{
+    Merge s;
+    s.ar = floatexp(2.0 * Zr);
+    s.ai = floatexp(2.0 * Zi);
+    s.br = floatexp(1);
+    s.bi = floatexp();
+    s.r = floatexp(BLA_EPSILON * 2.0 * sqrt(Zr * Zr + Zi * Zi));
+    return s;
+}
+
+// ----------------------------------------------------------------------------
+// x then y.  y is only good while x leaves |d| = |Ax*d + Bx*dc| under ry, so
+// r = min(rx, (ry - |Bx|*dcmax) / |Ax|)
+//
+template<typename T>
+typename BlaTable<T>::Merge BlaTable<T>::merge(const Merge &x, const Merge &y, const floatexp &dcmax)
+{
+    Merge s;
+    s.ar = y.ar * x.ar - y.ai * x.ai;
+    s.ai = y.ar * x.ai + y.ai * x.ar;
+    s.br = y.ar * x.br - y.ai * x.bi + y.br;
+    s.bi = y.ar * x.bi + y.ai * x.br + y.bi;
+
+    floatexp ax = sqrt(x.ar * x.ar + x.ai * x.ai);
+    floatexp room = y.r - sqrt(x.br * x.br + x.bi * x.bi) * dcmax;
+    if (room <= floatexp()) {
+        s.r = floatexp();
+    } else if (ax.mantissa() == 0.0) {
+        s.r = x.r; // d doesn't reach y at all
+    } else {
+        // room / ax, by way of its reciprocal
+        floatexp r = room * floatexp(1.0 / ax.mantissa(), -ax.exponent());
+        s.r = (r < x.r) ? r : x.r;
+    }
+    return s;
+}
+
+// ----------------------------------------------------------------------------
+static inline bool bla_finite(const double v) { return std::isfinite(v); }
+static inline bool bla_finite(const floatexp &v) { return true; }
+
+template<typename T>
+void BlaTable<T>::store(const Merge &x, BlaStep<T> *step)
+{
+    step->ar = (T)x.ar;
+    step->ai = (T)x.ai;
+    step->br = (T)x.br;
+    step->bi = (T)x.bi;
+    step->r2 = (T)(x.r * x.r);
+    // a step T can't hold is never taken
+    if (!bla_finite(step->ar) || !bla_finite(step->ai) || !bla_finite(step->br) || !bla_finite(step->bi)) {
+        step->r2 = T(0);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// the shortest level kept is the lowest whose table (about twice its own size
+// over all the levels) and scratch fit in cap.  that level is folded up one
+// plain step at a time, every level above it from pairs of the one below.
+//
+template<typename T>
+void BlaTable<T>::build(ReferenceOrbit *orbit, const floatexp dcmax, const size_t cap)
+{
+    m_reused = (orbit == m_orbit) && (orbit->generation() == m_generation) && (cap == m_cap) && 
+               (dcmax <= m_dcmax) && (m_dcmax < dcmax * floatexp(BLA_REUSE_RATIO));
+    if (m_reused) {
+        return;
+    }
+    m_orbit = orbit;
+    m_generation = orbit->generation();
+    m_dcmax = dcmax;
+    m_cap = cap;
+
+    // steps from Z_1 up to Z_length-2, a step from Z_m lands on Z_m+1
+    size_t count = (orbit->length() > 2) ? orbit->length() - 2 : 0;
+    const size_t per_step = 2 * sizeof(BlaStep<T>) + 2 * sizeof(Merge);
+
+    m_minLevel = 0;
+    while ((m_minLevel < BLA_MAX_LEVELS - 1) && ((count >> m_minLevel) * per_step > cap)) {
+        m_minLevel++;
+    }
+
+    m_prev.resize(count >> m_minLevel);
+    if (orbit->compressed()) {
+        OrbitWaypointCursor cursor(orbit);
+        fold(cursor, dcmax);
+    } else {
+        OrbitArrayCursor cursor(orbit);
+        fold(cursor, dcmax);
+    }
+
+    m_levels = m_minLevel;
+    for (int l = 0; l < BLA_MAX_LEVELS; l++)
+    {
+        if (l < m_minLevel || m_prev.empty()) {
+            m_table[l].clear();
+            continue;
+        }
+        m_table[l].resize(m_prev.size());
+        for (size_t k = 0; k < m_prev.size(); k++)
+        {
+            store(m_prev[k], &(m_table[l][k]));
+        }
+        m_levels = l + 1;
+
+        m_next.resize(m_prev.size() / 2);
+        for (size_t k = 0; k < m_next.size(); k++)
+        {
+            m_next[k] = merge(m_prev[2 * k], m_prev[2 * k + 1], dcmax);
+        }
+        m_prev.swap(m_next);
+    }
+
+    // the vectors keep their memory from frame to frame, unless a smaller cap
+    // (or a shorter orbit) leaves them holding more than the cap allows
+    if (capacity_bytes() > cap) {
+        for (int l = 0; l < BLA_MAX_LEVELS; l++) { m_table[l].shrink_to_fit(); }
+        m_prev.shrink_to_fit();
+        m_next.shrink_to_fit();
+    }
+    m_bytes = capacity_bytes();
+}
+
+// ----------------------------------------------------------------------------
+// the shortest level kept into m_prev, the steps from Z_1 on folded up in order
+//
+template<typename T>
+template<typename Orbit>
+void BlaTable<T>::fold(Orbit &orbit, const floatexp dcmax)
+{
+    orbit.seek(1);
+    for (size_t k = 0; k < m_prev.size(); k++)
+    {
+        Merge acc = single(orbit.re(), orbit.im());
+        orbit.next();
+        for (size_t j = 1; j < ((size_t)1 << m_minLevel); j++)
+        {
+            acc = merge(acc, single(orbit.re(), orbit.im()), dcmax);
+            orbit.next();
+        }
+        m_prev[k] = acc;
+    }
+}
+
+// ----------------------------------------------------------------------------
+template<typename T>
+size_t BlaTable<T>::capacity_bytes() const
+{
+    size_t bytes = (m_prev.capacity() + m_next.capacity()) * sizeof(Merge);
+    for (int l = 0; l < BLA_MAX_LEVELS; l++)
+    {
+        bytes += m_table[l].capacity() * sizeof(BlaStep<T>);
+    }
+    return bytes;
+}
+
+#endif /* BLA_TABLE_H */
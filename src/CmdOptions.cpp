@@ -4,12 +4,14 @@
 // class to parse the cmd line inputs
 
 #include <unistd.h>
+#include <string.h>
 #include <iostream>
 #include "CmdOptions.h"
 
 CmdOptions::CmdOptions()
- : m_factor(50), m_width(1024), m_height(1024),
-   m_real(""), m_imag("") 
+ : m_factor(50), m_width(1024), m_height(1024), m_algo(ALGO_MPFR),
+   m_glitchFix(GLITCHFIX_REBASE), m_frames(0), m_cacheSize(1024), m_subdivide(false),
+   m_real(""), m_imag(""), m_cacheDir("") 
 {
 }
 
@@ -17,16 +19,13 @@ CmdOptions::~CmdOptions()
 {
 }
 
-//enum { ALGO_MPFR, ALGO_THREAD };
-
 int CmdOptions::parseArgs(int argc, char **argv)
 {
   //int zoom = 0;
-  //int algo = ALGO_THREAD;
   int index = 0;
   int c = 0;
   
-  while((c = getopt(argc, argv, "hz:r:i:a:d:f:")) != -1)
+  while((c = getopt(argc, argv, "hz:r:i:a:g:n:c:m:d:f:s")) != -1)
   {
     switch (c)
     {
@@ -45,13 +44,54 @@ int CmdOptions::parseArgs(int argc, char **argv)
         m_imag = std::string(optarg);
         break;
       case 'a': // algo
-        std::cerr << "WARNING: algo is yet to be implemented.\n";
-        /*if (strcmp(optarg, "mpfr") == 0) {
-          algo = ALGO_MPFR; 
+        if (strcmp(optarg, "mpfr") == 0) {
+          m_algo = ALGO_MPFR; 
+        }
+        else if (strcmp(optarg, "fixed") == 0) {
+          m_algo = ALGO_FIXED; 
+        }
+        else if (strcmp(optarg, "perturbation") == 0) {
+          m_algo = ALGO_PERTURBATION; 
+        }
+        else if (strcmp(optarg, "bla") == 0) {
+          m_algo = ALGO_BLA; 
+        }
+        else {
+          std::cerr << "Unknown algorithm `" << optarg << "`.\n";
+          return 1;
+        }
+        break;
+      case 'g': // glitch correction
+        if (strcmp(optarg, "rebase") == 0) {
+          m_glitchFix = GLITCHFIX_REBASE; 
+        }
+        else if (strcmp(optarg, "references") == 0) {
+          m_glitchFix = GLITCHFIX_REFERENCES; 
+        }
+        else if (strcmp(optarg, "none") == 0) {
+          m_glitchFix = GLITCHFIX_NONE; 
+        }
+        else {
+          std::cerr << "Unknown glitch correction `" << optarg << "`.\n";
+          return 1;
+        }
+        break;
+      case 'n': // number of frames
+        m_frames = atoi(optarg);
+        if (m_frames < 0) { 
+            std::cerr << "Number of frames can't be negative.\n"; 
+            return 1; 
+        }
+        break;
+      case 'c': // reference orbit cache directory
+        m_cacheDir = std::string(optarg);
+        break;
+      case 'm': // reference orbit cache size
+        m_cacheSize = atoi(optarg);
+        if (m_cacheSize < 1) { 
+            std::cerr << "Orbit cache size must be at least 1 MB.\n"; 
+            return 1; 
         }
-        else if (strcmp(optarg, "thread") == 0) {
-          algo = ALGO_THREAD; 
-        }*/
         break;
       case 'd': // display size
         m_width = atoi(optarg);
@@ -68,6 +108,9 @@ int CmdOptions::parseArgs(int argc, char **argv)
       case 'f': // zoom step factor
         m_factor = atoi(optarg);
         break;
+      case 's': // fill rectangles with a uniform border
+        m_subdivide = true;
+        break;
       case '?':
         if ((optopt == 'f') || (optopt == 'v')) {
           std::cerr << "Option `-" << (char)optopt << "` requires an argument.\n";
@@ -104,7 +147,12 @@ void CmdOptions::usage()
   std::cout << "   -r  real value of point to zoom in to\n";
   std::cout << "   -i  imaginary value of point to zoom in to\n";
   std::cout << "   -d  display size (assumes a square)\n";
-  std::cout << "   -a  which algorithm (float, centre, mpfr, thread)\n";
+  std::cout << "   -a  which algorithm for deep zooms (mpfr, fixed, perturbation, bla)\n";
+  std::cout << "   -g  glitch correction for perturbation (rebase, references, none)\n";
+  std::cout << "   -n  number of frames to write (0, the default, zooms until the image bottoms out)\n";
+  std::cout << "   -c  directory to cache reference orbits in between runs (off by default)\n";
+  std::cout << "   -m  size limit of the orbit cache in MB (default 1024)\n";
   std::cout << "   -f  zoom factor\n";
+  std::cout << "   -s  skip rectangles whose border is all one iteration count (off by default)\n";
 }
 
@@ -8,6 +8,11 @@
 
 #include <string>
 
+// -a, how frames too deep for the hardware types are computed
+enum { ALGO_MPFR, ALGO_FIXED, ALGO_PERTURBATION, ALGO_BLA };
+// -g, how perturbation frames correct pixels that lose the reference orbit
+enum { GLITCHFIX_REBASE, GLITCHFIX_REFERENCES, GLITCHFIX_NONE };
+
 class CmdOptions {
   public:
     CmdOptions();
@@ -20,6 +25,12 @@ class CmdOptions {
     int getFactor() {return m_factor;}
     std::string& getReal() {return m_real;}
     std::string& getImag() {return m_imag;}
+    int getAlgo() {return m_algo;}
+    int getGlitchFix() {return m_glitchFix;}
+    int getFrames() {return m_frames;}
+    std::string& getCacheDir() {return m_cacheDir;}
+    int getCacheSize() {return m_cacheSize;}
+    bool getSubdivide() {return m_subdivide;}
 
   private:
     void usage();
@@ -27,8 +38,14 @@ class CmdOptions {
     int m_factor;
     int m_width;
     int m_height;
+    int m_algo;
+    int m_glitchFix;
+    int m_frames;
+    int m_cacheSize; // MB
+    bool m_subdivide;
     std::string m_real;
     std::string m_imag;
+    std::string m_cacheDir;
 };
 
 #endif // CMD_OPTIONS_H
@@ -0,0 +1,110 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// DoubleDouble.h
+
+// ddouble - an unevaluated sum of two doubles, hi + lo with |lo| <= ulp(hi)/2, about
+// 106 bits of mantissa in the range of a double.  every operation is built from the
+// error free transforms below, which give the rounding error of a double add or
+// multiply exactly as another double.  like floatexp it plugs into the kernels as a
+// template argument, calculate_point<ddouble>, filling the gap between long double
+// and mpfr for pixel spacings down to about 1e-30.
+//
+// the algorithms are those of the QD library (Hida, Li and Bailey).  they rely on
+// every double operation rounding once, to nearest, so nothing here may be built
+// with -ffast-math or fp contraction (the Makefile's -std=c++17 leaves it off).
+
+#ifndef DOUBLE_DOUBLE_H
+#define DOUBLE_DOUBLE_H
+
+#include <math.h>
+
+#define DDOUBLE_MANT_DIG 106
+#define DDOUBLE_SPLITTER 134217729.0 // 2^27 + 1
+
+// ----------------------------------------------------------------------------
+// error free transforms, each returns the rounded result and leaves the error in err
+//
+
+// a + b, any a and b
+inline double two_sum(const double a, const double b, double &err)
+{
+    double s = a + b;
+    double bb = s - a;
+    err = (a - (s - bb)) + (b - bb);
+    return s;
+}
+
+// a + b where |a| >= |b|
+inline double quick_two_sum(const double a, const double b, double &err)
+{
+    double s = a + b;
+    err = b - (s - a);
+    return s;
+}
+
+// a * b, with a fused multiply add where the cpu is built for it, else Dekker's
+// split of each operand into two 26 bit halves whose products are exact
+inline double two_prod(const double a, const double b, double &err)
+{
+    double p = a * b;
+#if defined(__FMA__)
+    err = fma(a, b, -p);
+#else
+    double t = DDOUBLE_SPLITTER * a;
+    double ahi = t - (t - a), alo = a - ahi;
+    t = DDOUBLE_SPLITTER * b;
+    double bhi = t - (t - b), blo = b - bhi;
+    err = ((ahi * bhi - p) + ahi * blo + alo * bhi) + alo * blo;
+#endif
+    return p;
+}
+
+class ddouble
+{
+  public:
+    ddouble() : hi(0.0), lo(0.0) {}
+    ddouble(const double v) : hi(v), lo(0.0) {}
+    ddouble(const int v) : hi((double)v), lo(0.0) {}
+    // h + l, not necessarily normalised
+    ddouble(const double h, const double l) { hi = quick_two_sum(h, l, lo); }
+
+    explicit operator double() const { return hi; }
+    double high() const { return hi; }
+    double low() const { return lo; }
+
+    ddouble operator-() const { ddouble r; r.hi = -hi; r.lo = -lo; return r; }
+
+    friend ddouble operator+(const ddouble &a, const ddouble &b)
+    {
+        // the his and the los summed separately, so a cancellation between the his
+        // doesn't lose the los
+        double e1, e2;
+        double s = two_sum(a.hi, b.hi, e1);
+        double t = two_sum(a.lo, b.lo, e2);
+        e1 += t;
+        s = quick_two_sum(s, e1, e1);
+        e1 += e2;
+        ddouble r;
+        r.hi = quick_two_sum(s, e1, r.lo);
+        return r;
+    }
+
+    friend ddouble operator-(const ddouble &a, const ddouble &b) { return a + (-b); }
+
+    friend ddouble operator*(const ddouble &a, const ddouble &b)
+    {
+        double e;
+        double p = two_prod(a.hi, b.hi, e);
+        e += a.hi * b.lo + a.lo * b.hi;
+        ddouble r;
+        r.hi = quick_two_sum(p, e, r.lo);
+        return r;
+    }
+
+    friend bool operator<=(const ddouble &a, const ddouble &b) { return (a.hi < b.hi) || ((a.hi == b.hi) && (a.lo <= b.lo)); }
+    friend bool operator<(const ddouble &a, const ddouble &b) { return (a.hi < b.hi) || ((a.hi == b.hi) && (a.lo < b.lo)); }
+
+  private:
+    double hi, lo;
+};
+
+#endif /* DOUBLE_DOUBLE_H */
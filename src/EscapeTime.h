@@ -0,0 +1,107 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// EscapeTime.h
+
+// the escape time kernel written once over the numeric type, so the same loop can
+// run in float, double, long double, ddouble or qdouble (or any type with the usual
+// arithmetic operators) depending on how many bits the current frame needs
+
+#ifndef ESCAPE_TIME_H
+#define ESCAPE_TIME_H
+
+/* ----------------------------------------------------------------------------
+ * calculate_point
+ * run the z = z^2 + c algorithm for the point provided to assertain if the
+ * point is inside or outside of the mandelbrot set
+ *
+ * the bailout test uses |z|^2 from the previous step, exactly as the mpfr
+ * loop in worker_process_slice does, so every type gives the same count
+ * for a point it can resolve
+ *
+ * with eps > 0 the orbit is also checked for a cycle (Brent): z is saved at
+ * every power of two iterations and each z after is compared with it, one
+ * back within eps in x and y has settled into a cycle and the point is
+ * interior, counted as maxiter without running the rest of the way
+ *
+ * Params
+ * x0, y0 (T) location to calculate for
+ * maxiter (int) the escape value
+ * eps (T) periodicity tolerance, 0 for none
+ *
+ * Returns
+ * iteration - count of how many iterations it took to head to infinity
+ */
+template<typename T>
+inline bool within_eps(const T d, const T eps)
+{
+    return (-eps < d) && (d < eps);
+}
+
+template<typename T>
+inline unsigned int calculate_point(const T x0, const T y0, const unsigned int maxiter, const T eps = T(0))
+{
+    T x = T(0);
+    T y = T(0);
+    T xsq = T(0);
+    T ysq = T(0);
+    T xtemp = T(0);
+    T xy = T(0);
+    T xs = T(0); // z at the last power of two
+    T ys = T(0);
+    const bool periodic = (T(0) < eps);
+    unsigned int save = 1;
+    unsigned int iteration = 0;
+
+    while (((xsq + ysq) <= T(4)) && iteration < maxiter)
+    {
+        xsq = x*x;
+        ysq = y*y;
+        xtemp = xsq - ysq + x0;
+        xy = x*y;
+        y = xy + xy + y0; // 2*x*y, an add is cheaper than a multiply for the multi-double types
+        x = xtemp;
+        iteration++;
+
+        if (periodic) {
+            if (within_eps(x - xs, eps) && within_eps(y - ys, eps)) {
+                return maxiter;
+            }
+            if (iteration == save) {
+                xs = x;
+                ys = y;
+                save *= 2;
+            }
+        }
+    }
+    return iteration;
+}
+
+/* ----------------------------------------------------------------------------
+ * in_main_bulbs
+ * true if c = (x0, y0) is inside the main cardioid or the period 2 bulb, a
+ * point calculate_point would run all the way to maxiter.  with
+ * q = (x0 - 1/4)^2 + y0^2 the cardioid is q*(q + x0 - 1/4) <= y0^2/4 and the
+ * bulb is (x0 + 1)^2 + y0^2 <= 1/16.  both are shrunk by BULB_MARGIN so a
+ * point the rounding might put on the wrong side is left to the loop, which
+ * also means a deep view on the boundary has nothing rejected
+ *
+ * Params
+ * x0, y0 (double) location to test
+ *
+ * Returns
+ * true if the point is in the set without iterating
+ */
+#define BULB_MARGIN 1e-12
+
+inline bool in_main_bulbs(const double x0, const double y0)
+{
+    const double ysq = y0 * y0;
+    const double xq = x0 - 0.25;
+    const double q = xq * xq + ysq;
+    if (q * (q + xq) < 0.25 * ysq - BULB_MARGIN) {
+        return true;
+    }
+    const double xb = x0 + 1.0;
+    return (xb * xb + ysq < 0.0625 - BULB_MARGIN);
+}
+
+#endif /* ESCAPE_TIME_H */
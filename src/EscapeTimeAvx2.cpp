@@ -0,0 +1,115 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// EscapeTimeAvx2.cpp
+
+// 4 doubles per instruction, built with -mavx2 (see the Makefile) and only called once
+// simd_best_level() has seen avx2 on the cpu
+
+#include "EscapeTimeSimd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+/* ----------------------------------------------------------------------------
+ * escape_lanes_avx2
+ *
+ * calculate_point<double> for 4 pixels at once.  a lane stays active while its
+ * xsq+ysq <= 4, once it escapes it is masked off for good and its count stops,
+ * the loop ends when every lane has escaped or maxiter is reached.  counts are
+ * kept as doubles (exact far beyond any maxiter) so the mask can be added in.
+ * there is no fused multiply add, each step rounds exactly as the scalar one.
+ * the cycle check is the scalar one too, every active lane has done the same
+ * number of iterations so they all save z at the same step, and a lane that
+ * comes back within eps is given maxiter and masked off as if it had escaped.
+ * the counts of the first n lanes go to iterations
+ */
+static inline void escape_lanes_avx2(const __m256d vx0, const __m256d vy0, const unsigned int n,
+                                     const unsigned int maxiter, const double eps, unsigned int *iterations)
+{
+    const __m256d four = _mm256_set1_pd(4.0);
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d lane = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);
+    const __m256d veps = _mm256_set1_pd(eps);
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    const __m256d vmaxiter = _mm256_set1_pd((double)maxiter);
+    double counts[4];
+
+    // lanes past the end of the run start inactive
+    __m256d active = _mm256_cmp_pd(lane, _mm256_set1_pd((double)n), _CMP_LT_OQ);
+    __m256d x = _mm256_setzero_pd();
+    __m256d y = _mm256_setzero_pd();
+    __m256d xsq = _mm256_setzero_pd();
+    __m256d ysq = _mm256_setzero_pd();
+    __m256d iteration = _mm256_setzero_pd();
+    __m256d xs = _mm256_setzero_pd();
+    __m256d ys = _mm256_setzero_pd();
+    unsigned int save = 1;
+
+    for (unsigned int k = 0; k < maxiter; k++)
+    {
+        active = _mm256_and_pd(active, _mm256_cmp_pd(_mm256_add_pd(xsq, ysq), four, _CMP_LE_OQ));
+        if (_mm256_movemask_pd(active) == 0) {
+            break;
+        }
+        xsq = _mm256_mul_pd(x, x);
+        ysq = _mm256_mul_pd(y, y);
+        __m256d xtemp = _mm256_add_pd(_mm256_sub_pd(xsq, ysq), vx0);
+        y = _mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(two, x), y), vy0);
+        x = xtemp;
+        iteration = _mm256_add_pd(iteration, _mm256_and_pd(active, one));
+
+        if (eps > 0.0) {
+            __m256d near = _mm256_and_pd(
+                _mm256_cmp_pd(_mm256_andnot_pd(sign, _mm256_sub_pd(x, xs)), veps, _CMP_LT_OQ),
+                _mm256_cmp_pd(_mm256_andnot_pd(sign, _mm256_sub_pd(y, ys)), veps, _CMP_LT_OQ));
+            near = _mm256_and_pd(near, active);
+            if (_mm256_movemask_pd(near) != 0) {
+                iteration = _mm256_blendv_pd(iteration, vmaxiter, near);
+                active = _mm256_andnot_pd(near, active);
+            }
+            if (k + 1 == save) {
+                xs = x;
+                ys = y;
+                save *= 2;
+            }
+        }
+    }
+
+    _mm256_storeu_pd(counts, iteration);
+    for (unsigned int j = 0; j < n; j++)
+    {
+        iterations[j] = (unsigned int)counts[j];
+    }
+}
+
+// ----------------------------------------------------------------------------
+void escape_row_avx2(const double Xs, const double dx, const unsigned int x0, const unsigned int count,
+                     const double y0, const unsigned int maxiter, const double eps, unsigned int *iterations)
+{
+    const __m256d lane = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);
+
+    for (unsigned int i = 0; i < count; i += 4)
+    {
+        unsigned int n = (count - i < 4) ? count - i : 4;
+
+        // x0 = Xs + Dx*dx
+        __m256d vx0 = _mm256_add_pd(_mm256_set1_pd((double)(x0 + i)), lane);
+        vx0 = _mm256_add_pd(_mm256_set1_pd(Xs), _mm256_mul_pd(vx0, _mm256_set1_pd(dx)));
+        escape_lanes_avx2(vx0, _mm256_set1_pd(y0), n, maxiter, eps, iterations + i);
+    }
+}
+
+// ----------------------------------------------------------------------------
+void escape_column_avx2(const double x0, const double *y0, const unsigned int count,
+                        const unsigned int maxiter, const double eps, unsigned int *iterations)
+{
+    for (unsigned int i = 0; i < count; i += 4)
+    {
+        unsigned int n = (count - i < 4) ? count - i : 4;
+        double ys[4] = { 0.0, 0.0, 0.0, 0.0 };
+        for (unsigned int j = 0; j < n; j++) { ys[j] = y0[i + j]; }
+        escape_lanes_avx2(_mm256_set1_pd(x0), _mm256_loadu_pd(ys), n, maxiter, eps, iterations + i);
+    }
+}
+
+#endif
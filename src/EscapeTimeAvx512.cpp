@@ -0,0 +1,103 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// EscapeTimeAvx512.cpp
+
+// 8 doubles per instruction, built with -mavx512f (see the Makefile) and only called
+// once simd_best_level() has seen avx512f on the cpu
+
+#include "EscapeTimeSimd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+/* ----------------------------------------------------------------------------
+ * escape_lanes_avx512
+ *
+ * as escape_lanes_avx2 but 8 lanes wide, with the active lanes held in a mask
+ * register so the count is a masked add
+ */
+static inline void escape_lanes_avx512(const __m512d vx0, const __m512d vy0, const unsigned int n,
+                                       const unsigned int maxiter, const double eps, unsigned int *iterations)
+{
+    const __m512d four = _mm512_set1_pd(4.0);
+    const __m512d two = _mm512_set1_pd(2.0);
+    const __m512d one = _mm512_set1_pd(1.0);
+    const __m512d veps = _mm512_set1_pd(eps);
+    const __m512d vmaxiter = _mm512_set1_pd((double)maxiter);
+    double counts[8];
+
+    // lanes past the end of the run start inactive
+    __mmask8 active = (__mmask8)((1u << n) - 1);
+    __m512d x = _mm512_setzero_pd();
+    __m512d y = _mm512_setzero_pd();
+    __m512d xsq = _mm512_setzero_pd();
+    __m512d ysq = _mm512_setzero_pd();
+    __m512d iteration = _mm512_setzero_pd();
+    __m512d xs = _mm512_setzero_pd();
+    __m512d ys = _mm512_setzero_pd();
+    unsigned int save = 1;
+
+    for (unsigned int k = 0; k < maxiter; k++)
+    {
+        active = _mm512_mask_cmp_pd_mask(active, _mm512_add_pd(xsq, ysq), four, _CMP_LE_OQ);
+        if (active == 0) {
+            break;
+        }
+        xsq = _mm512_mul_pd(x, x);
+        ysq = _mm512_mul_pd(y, y);
+        __m512d xtemp = _mm512_add_pd(_mm512_sub_pd(xsq, ysq), vx0);
+        y = _mm512_add_pd(_mm512_mul_pd(_mm512_mul_pd(two, x), y), vy0);
+        x = xtemp;
+        iteration = _mm512_mask_add_pd(iteration, active, iteration, one);
+
+        if (eps > 0.0) {
+            __mmask8 near = _mm512_mask_cmp_pd_mask(active, _mm512_abs_pd(_mm512_sub_pd(x, xs)), veps, _CMP_LT_OQ);
+            near = _mm512_mask_cmp_pd_mask(near, _mm512_abs_pd(_mm512_sub_pd(y, ys)), veps, _CMP_LT_OQ);
+            if (near != 0) {
+                iteration = _mm512_mask_mov_pd(iteration, near, vmaxiter);
+                active = (__mmask8)(active & ~near);
+            }
+            if (k + 1 == save) {
+                xs = x;
+                ys = y;
+                save *= 2;
+            }
+        }
+    }
+
+    _mm512_storeu_pd(counts, iteration);
+    for (unsigned int j = 0; j < n; j++)
+    {
+        iterations[j] = (unsigned int)counts[j];
+    }
+}
+
+// ----------------------------------------------------------------------------
+void escape_row_avx512(const double Xs, const double dx, const unsigned int x0, const unsigned int count,
+                       const double y0, const unsigned int maxiter, const double eps, unsigned int *iterations)
+{
+    const __m512d lane = _mm512_set_pd(7.0, 6.0, 5.0, 4.0, 3.0, 2.0, 1.0, 0.0);
+
+    for (unsigned int i = 0; i < count; i += 8)
+    {
+        unsigned int n = (count - i < 8) ? count - i : 8;
+
+        // x0 = Xs + Dx*dx
+        __m512d vx0 = _mm512_add_pd(_mm512_set1_pd((double)(x0 + i)), lane);
+        vx0 = _mm512_add_pd(_mm512_set1_pd(Xs), _mm512_mul_pd(vx0, _mm512_set1_pd(dx)));
+        escape_lanes_avx512(vx0, _mm512_set1_pd(y0), n, maxiter, eps, iterations + i);
+    }
+}
+
+// ----------------------------------------------------------------------------
+void escape_column_avx512(const double x0, const double *y0, const unsigned int count,
+                          const unsigned int maxiter, const double eps, unsigned int *iterations)
+{
+    for (unsigned int i = 0; i < count; i += 8)
+    {
+        unsigned int n = (count - i < 8) ? count - i : 8;
+        __m512d vy0 = _mm512_maskz_loadu_pd((__mmask8)((1u << n) - 1), y0 + i);
+        escape_lanes_avx512(_mm512_set1_pd(x0), vy0, n, maxiter, eps, iterations + i);
+    }
+}
+
+#endif
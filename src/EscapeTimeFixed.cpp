@@ -0,0 +1,390 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// EscapeTimeFixed.cpp
+
+// the fixed point row kernel, one instantiation per limb count so every mpn_* call
+// has a constant length and the working arrays live on the stack
+
+#include <array>
+#include <utility>
+#include <gmp.h>
+#include <mpfr.h>
+
+#include "EscapeTimeFixed.h"
+
+// binary places below the point
+#define FIXED_FRACTION_BITS(limbs) ((limbs) * GMP_NUMB_BITS - FIXED_INTEGER_BITS)
+// 4.0 in the top limb, the rest zero
+#define FIXED_FOUR ((mp_limb_t)4 << (GMP_NUMB_BITS - FIXED_INTEGER_BITS))
+
+// a signed fixed point number, d[0] the least significant limb as mpn has it
+template<int LIMBS>
+struct Fixed { mp_limb_t d[LIMBS]; bool neg; };
+
+// ----------------------------------------------------------------------------
+// get_z_2exp - mpfr_get_z_2exp for a regular v, without its realloc of z to just
+// the mantissa's limbs, after which the shift would grow z again on every call
+//
+static mpfr_exp_t get_z_2exp(mpz_ptr z, mpfr_srcptr v)
+{
+    const mp_size_t n = (mp_size_t)((mpfr_get_prec(v) - 1) / GMP_NUMB_BITS + 1);
+    mp_limb_t *d = mpz_limbs_write(z, n);
+    mpn_copyi(d, (const mp_limb_t*)mpfr_custom_get_significand(v), n);
+    mpz_limbs_finish(z, mpfr_signbit(v) ? -n : n);
+    return mpfr_get_exp(v) - (mpfr_exp_t)n * GMP_NUMB_BITS;
+}
+
+// ----------------------------------------------------------------------------
+// to_fixed - v truncated to FIXED_FRACTION_BITS places, z is scratch
+//
+template<int LIMBS>
+static void to_fixed(Fixed<LIMBS> *f, mpfr_srcptr v, mpz_ptr z)
+{
+    if (mpfr_zero_p(v)) {
+        mpz_set_ui(z, 0);
+    } else {
+        // v = z * 2^exp, then shifted so the point is FIXED_FRACTION_BITS up
+        long shift = (long)get_z_2exp(z, v) + FIXED_FRACTION_BITS(LIMBS);
+        if (shift >= 0) {
+            mpz_mul_2exp(z, z, (mp_bitcnt_t)shift);
+        } else {
+            mpz_tdiv_q_2exp(z, z, (mp_bitcnt_t)(-shift));
+        }
+    }
+    f->neg = (mpz_sgn(z) < 0);
+    for (int i = 0; i < LIMBS; i++)
+    {
+        f->d[i] = mpz_getlimbn(z, i); // 0 past the top of z
+    }
+}
+
+// ----------------------------------------------------------------------------
+// fixed_add - r = a + b on sign and magnitude, returns the sign of r.  r may be
+// a or b
+//
+template<int LIMBS>
+static inline bool fixed_add(mp_limb_t *r, const mp_limb_t *a, const bool an, const mp_limb_t *b, const bool bn)
+{
+    if (an == bn) {
+        mpn_add_n(r, a, b, LIMBS);
+        return an;
+    }
+    if (mpn_cmp(a, b, LIMBS) >= 0) {
+        mpn_sub_n(r, a, b, LIMBS);
+        return an;
+    }
+    mpn_sub_n(r, b, a, LIMBS);
+    return bn;
+}
+
+// ----------------------------------------------------------------------------
+// fixed_mul - the magnitude of a*b (squared when a is b) in prod, which has room
+// for the whole 2*LIMBS limb product.  shifting the top LIMBS+1 limbs up by
+// FIXED_INTEGER_BITS puts the point back in place in prod[LIMBS..2*LIMBS), the
+// bits below are dropped.  returns the result
+//
+template<int LIMBS>
+static inline const mp_limb_t* fixed_mul(mp_limb_t *prod, const mp_limb_t *a, const mp_limb_t *b)
+{
+    if (a == b) {
+        mpn_sqr(prod, a, LIMBS);
+    } else {
+        mpn_mul_n(prod, a, b, LIMBS);
+    }
+    mpn_lshift(prod + LIMBS - 1, prod + LIMBS - 1, LIMBS + 1, FIXED_INTEGER_BITS);
+    return prod + LIMBS;
+}
+
+// ----------------------------------------------------------------------------
+// the cycle check's |d| < 2^eps_exp on a magnitude: every bit from FIXED_FRACTION_BITS
+// + eps_exp up is clear.  limb is where that bit falls and mask its bits from there
+//
+struct FixedNear { int limb; mp_limb_t mask; };
+
+template<int LIMBS>
+static FixedNear fixed_near_bits(const long eps_exp)
+{
+    long b = (long)FIXED_FRACTION_BITS(LIMBS) + eps_exp;
+    b = (b < 0) ? 0 : b;
+    b = (b > (long)LIMBS * GMP_NUMB_BITS - 1) ? (long)LIMBS * GMP_NUMB_BITS - 1 : b;
+    FixedNear near = { (int)(b / GMP_NUMB_BITS), ~(mp_limb_t)0 << (b % GMP_NUMB_BITS) };
+    return near;
+}
+
+template<int LIMBS>
+static inline bool fixed_within(const mp_limb_t *d, const FixedNear &near)
+{
+    for (int i = LIMBS - 1; i > near.limb; i--)
+    {
+        if (d[i] != 0) {
+            return false;
+        }
+    }
+    return (d[near.limb] & near.mask) == 0;
+}
+
+// ----------------------------------------------------------------------------
+// fixed_escape - calculate_point in fixed point, the bailout test on |z|^2 from
+// the previous step as every other tier has it, and with periodic set the same
+// cycle check, near the z saved at the last power of two iterations
+//
+// a square costs less than a multiply, so the cross term is a third square,
+// 2*x*y = (x+y)^2 - (xsq + ysq), with the sum needed for the while test anyway.
+// |x+y|^2 <= 2*|z|^2 so it stays inside the integer bits too
+//
+template<int LIMBS>
+static unsigned int fixed_escape(const Fixed<LIMBS> &cx, const Fixed<LIMBS> &cy, const unsigned int maxiter,
+                                 const bool periodic, const FixedNear &near)
+{
+    mp_limb_t x[LIMBS] = { 0 }, y[LIMBS] = { 0 }, sum[LIMBS] = { 0 }, xpy[LIMBS];
+    mp_limb_t xsq[2 * LIMBS], ysq[2 * LIMBS], xy[2 * LIMBS];
+    mp_limb_t xs[LIMBS] = { 0 }, ys[LIMBS] = { 0 }, d[LIMBS]; // z at the last power of two
+    mp_limb_t *XY = xy + LIMBS;
+    bool xneg = false, yneg = false, xyneg;
+    bool xsneg = false, ysneg = false;
+    bool inside = true; // xsq + ysq <= 4
+    unsigned int save = 1;
+    unsigned int iteration = 0;
+
+    while (inside && (iteration < maxiter))
+    {
+        const mp_limb_t *X = fixed_mul<LIMBS>(xsq, x, x);             // xsq = x*x
+        const mp_limb_t *Y = fixed_mul<LIMBS>(ysq, y, y);             // ysq = y*y
+        fixed_add<LIMBS>(xpy, x, xneg, y, yneg);                      // |x + y|
+        fixed_mul<LIMBS>(xy, xpy, xpy);
+        mpn_add_n(sum, X, Y, LIMBS);                                  // xsq + ysq
+        xyneg = fixed_add<LIMBS>(XY, XY, false, sum, true);           // 2*x*y
+        yneg = fixed_add<LIMBS>(y, XY, xyneg, cy.d, cy.neg);          // y = 2*x*y + y0
+        xneg = fixed_add<LIMBS>(x, X, false, Y, true);                // x = xsq - ysq + x0
+        xneg = fixed_add<LIMBS>(x, x, xneg, cx.d, cx.neg);
+
+        // calcs for while test, only the top limb can reach 4
+        inside = (sum[LIMBS - 1] < FIXED_FOUR) ||
+                 ((sum[LIMBS - 1] == FIXED_FOUR) && mpn_zero_p(sum, LIMBS - 1));
+        iteration++;
+
+        if (periodic) {
+            fixed_add<LIMBS>(d, x, xneg, xs, !xsneg);
+            if (fixed_within<LIMBS>(d, near)) {
+                fixed_add<LIMBS>(d, y, yneg, ys, !ysneg);
+                if (fixed_within<LIMBS>(d, near)) {
+                    return maxiter;
+                }
+            }
+            if (iteration == save) {
+                mpn_copyi(xs, x, LIMBS);
+                mpn_copyi(ys, y, LIMBS);
+                xsneg = xneg;
+                ysneg = yneg;
+                save *= 2;
+            }
+        }
+    }
+    return iteration;
+}
+
+// ----------------------------------------------------------------------------
+// escape_row_fixed - the first pixel and the spacing go to fixed point once, then
+// every pixel of the run is one add on from the last
+//
+template<int LIMBS>
+static void escape_row_fixed(mpfr_srcptr Xs, mpfr_srcptr dx, const unsigned int x0, const unsigned int count,
+                             mpfr_srcptr y0, const unsigned int maxiter, const long eps_exp, unsigned int *iterations,
+                             FixedScratch *scratch)
+{
+    const FixedNear near = fixed_near_bits<LIMBS>(eps_exp);
+    Fixed<LIMBS> cx, cy, step;
+
+    mpfr_mul_ui(scratch->t, dx, x0, MPFR_RNDN);
+    mpfr_add(scratch->t, scratch->t, Xs, MPFR_RNDN);
+    to_fixed<LIMBS>(&cx, scratch->t, scratch->z);
+    to_fixed<LIMBS>(&step, dx, scratch->z);
+    to_fixed<LIMBS>(&cy, y0, scratch->z);
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        iterations[i] = fixed_escape<LIMBS>(cx, cy, maxiter, eps_exp != 0, near);
+        cx.neg = fixed_add<LIMBS>(cx.d, cx.d, cx.neg, step.d, step.neg); // x0 of the next column
+    }
+}
+
+// ----------------------------------------------------------------------------
+// escape_column_fixed - the column's x goes to fixed point once, each pixel's y
+// is worked out in mpfr first
+//
+template<int LIMBS>
+static void escape_column_fixed(mpfr_srcptr x0, mpfr_srcptr Ys, mpfr_srcptr dy, const unsigned int y0,
+                                const unsigned int count, const unsigned int maxiter, const long eps_exp,
+                                unsigned int *iterations, FixedScratch *scratch)
+{
+    const FixedNear near = fixed_near_bits<LIMBS>(eps_exp);
+    Fixed<LIMBS> cx, cy;
+
+    to_fixed<LIMBS>(&cx, x0, scratch->z);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        mpfr_mul_ui(scratch->t, dy, y0 + i, MPFR_RNDN);
+        mpfr_add(scratch->t, scratch->t, Ys, MPFR_RNDN);
+        to_fixed<LIMBS>(&cy, scratch->t, scratch->z);
+        iterations[i] = fixed_escape<LIMBS>(cx, cy, maxiter, eps_exp != 0, near);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// one kernel per limb count, FIXED_MIN_LIMBS first
+//
+template<int... N>
+static constexpr std::array<fixed_row_fn, sizeof...(N)> row_kernels(std::integer_sequence<int, N...>)
+{
+    return {{ escape_row_fixed<N + FIXED_MIN_LIMBS>... }};
+}
+
+template<int... N>
+static constexpr std::array<fixed_column_fn, sizeof...(N)> column_kernels(std::integer_sequence<int, N...>)
+{
+    return {{ escape_column_fixed<N + FIXED_MIN_LIMBS>... }};
+}
+
+static const std::array<fixed_row_fn, FIXED_MAX_LIMBS - FIXED_MIN_LIMBS + 1> kernels =
+    row_kernels(std::make_integer_sequence<int, FIXED_MAX_LIMBS - FIXED_MIN_LIMBS + 1>());
+static const std::array<fixed_column_fn, FIXED_MAX_LIMBS - FIXED_MIN_LIMBS + 1> columns =
+    column_kernels(std::make_integer_sequence<int, FIXED_MAX_LIMBS - FIXED_MIN_LIMBS + 1>());
+
+// ----------------------------------------------------------------------------
+// to_lane_limbs - v truncated to the vector kernels' fraction bits, as n limbs of
+// FIXED_LANE_BITS, z is scratch
+//
+static void to_lane_limbs(int64_t *d, const int n, mpfr_srcptr v, mpz_ptr z)
+{
+    const long fraction = (long)n * FIXED_LANE_BITS - FIXED_INTEGER_BITS;
+    if (mpfr_zero_p(v)) {
+        mpz_set_ui(z, 0);
+    } else {
+        long shift = (long)get_z_2exp(z, v) + fraction;
+        if (shift >= 0) {
+            mpz_mul_2exp(z, z, (mp_bitcnt_t)shift);
+        } else {
+            mpz_tdiv_q_2exp(z, z, (mp_bitcnt_t)(-shift));
+        }
+    }
+    // the magnitude a limb at a time, then negated limb by limb and carried
+    const int64_t sign = (mpz_sgn(z) < 0) ? -1 : 1;
+    for (int k = 0; k < n; k++)
+    {
+        const mp_bitcnt_t bit = (mp_bitcnt_t)k * FIXED_LANE_BITS;
+        const mp_size_t limb = (mp_size_t)(bit / GMP_NUMB_BITS);
+        const unsigned int offset = (unsigned int)(bit % GMP_NUMB_BITS);
+        mp_limb_t bits = mpz_getlimbn(z, limb) >> offset;
+        if (offset + FIXED_LANE_BITS > GMP_NUMB_BITS) {
+            bits |= mpz_getlimbn(z, limb + 1) << (GMP_NUMB_BITS - offset);
+        }
+        d[k] = sign * (int64_t)(bits & (((mp_limb_t)1 << FIXED_LANE_BITS) - 1));
+    }
+    int64_t zero[FIXED_LANE_LIMBS(FIXED_MAX_LIMBS)] = { 0 };
+    fixed_lane_add(d, zero, n);
+}
+
+// ----------------------------------------------------------------------------
+void fixed_lane_row(int64_t *start, int64_t *step, int64_t *y, const int n,
+                    mpfr_srcptr Xs, mpfr_srcptr dx, const unsigned int x0, mpfr_srcptr y0,
+                    FixedScratch *scratch)
+{
+    mpfr_mul_ui(scratch->t, dx, x0, MPFR_RNDN);
+    mpfr_add(scratch->t, scratch->t, Xs, MPFR_RNDN);
+    to_lane_limbs(start, n, scratch->t, scratch->z);
+    to_lane_limbs(step, n, dx, scratch->z);
+    to_lane_limbs(y, n, y0, scratch->z);
+}
+
+// ----------------------------------------------------------------------------
+void fixed_lane_value(int64_t *d, const int n, mpfr_srcptr v, FixedScratch *scratch)
+{
+    to_lane_limbs(d, n, v, scratch->z);
+}
+
+// ----------------------------------------------------------------------------
+void fixed_lane_add(int64_t *a, const int64_t *b, const int n)
+{
+    for (int k = 0; k < n; k++)
+    {
+        a[k] += b[k];
+    }
+    for (int k = 0; k < n - 1; k++)
+    {
+        a[k + 1] += a[k] >> FIXED_LANE_BITS; // arithmetic, borrows come through as -1
+        a[k] &= ((int64_t)1 << FIXED_LANE_BITS) - 1;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// a fixed value never has more bits than the limbs for the precision (or the
+// vector limbs holding them) and z also takes the mantissa before it is shifted,
+// so the precision and a few limbs more is always enough
+//
+void fixed_scratch_init(FixedScratch *scratch, const int precision)
+{
+    mpfr_init2(scratch->t, precision);
+    mpz_init2(scratch->z, (mp_bitcnt_t)precision + 4 * GMP_NUMB_BITS);
+}
+
+// ----------------------------------------------------------------------------
+void fixed_scratch_clear(FixedScratch *scratch)
+{
+    mpfr_clear(scratch->t);
+    mpz_clear(scratch->z);
+}
+
+// ----------------------------------------------------------------------------
+int fixed_limbs(const int precision)
+{
+    int limbs = (precision + GMP_NUMB_BITS - 1) / GMP_NUMB_BITS;
+    return (limbs < FIXED_MIN_LIMBS) ? FIXED_MIN_LIMBS : limbs;
+}
+
+// ----------------------------------------------------------------------------
+// |z| stays under 2^FIXED_INTEGER_BITS while |c| < FIXED_MAX_COORD*sqrt(2): a z
+// only gets squared if the one before had |z|^2 <= 4, so |z| <= 4 + |c| and
+// nothing the loop computes gets past (4 + |c|)^2 + |c|, about 100
+//
+bool fixed_point_fits(mpfr_srcptr Xs, mpfr_srcptr Xe, mpfr_srcptr Ys, mpfr_srcptr Ye)
+{
+    mpfr_srcptr corners[4] = { Xs, Xe, Ys, Ye };
+    for (mpfr_srcptr corner : corners)
+    {
+        if ((mpfr_cmp_si(corner, -FIXED_MAX_COORD) <= 0) || (mpfr_cmp_si(corner, FIXED_MAX_COORD) >= 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+fixed_row_fn fixed_escape_row(const int limbs, const SimdLevel level)
+{
+    if ((limbs < FIXED_MIN_LIMBS) || (limbs > FIXED_MAX_LIMBS)) {
+        return NULL;
+    }
+    switch (level)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        case SIMD_AVX512: return fixed_escape_row_avx512(limbs);
+        case SIMD_AVX2:   return fixed_escape_row_avx2(limbs);
+#endif
+        default:          return kernels[limbs - FIXED_MIN_LIMBS];
+    }
+}
+
+// ----------------------------------------------------------------------------
+fixed_column_fn fixed_escape_column(const int limbs, const SimdLevel level)
+{
+    if ((limbs < FIXED_MIN_LIMBS) || (limbs > FIXED_MAX_LIMBS)) {
+        return NULL;
+    }
+    switch (level)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        case SIMD_AVX512: return fixed_escape_column_avx512(limbs);
+        case SIMD_AVX2:   return fixed_escape_column_avx2(limbs);
+#endif
+        default:          return columns[limbs - FIXED_MIN_LIMBS];
+    }
+}
@@ -0,0 +1,98 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// EscapeTimeFixed.h
+
+// the escape time loop in fixed point, for frames too deep for the hardware types.
+// a number is a sign and a magnitude of LIMBS GMP limbs, FIXED_INTEGER_BITS of them
+// above the binary point, and the loop is a handful of mpn_* calls on arrays whose
+// length is known at compile time - none of mpfr's exponent handling, rounding or
+// per call dispatch.  the products are truncated rather than rounded, so a count
+// can differ from the mpfr loop's on a pixel right at the edge of escaping.
+//
+// every z the loop computes stays below 2^FIXED_INTEGER_BITS as long as the view
+// does not reach past |x|, |y| < FIXED_MAX_COORD (see fixed_point_fits).
+//
+// with avx2 or avx512 the loop can instead run 4 or 8 pixels of the row at once, each
+// number held as FIXED_LANE_BITS limbs across the vector lanes (see
+// EscapeTimeFixedLanes.h).
+
+#ifndef ESCAPE_TIME_FIXED_H
+#define ESCAPE_TIME_FIXED_H
+
+#include <stdint.h>
+#include <gmp.h>
+#include <mpfr.h>
+#include "EscapeTimeSimd.h"
+
+#define FIXED_MIN_LIMBS     2
+#define FIXED_MAX_LIMBS    32
+#define FIXED_INTEGER_BITS  8 // |z| < 256, the bits above the binary point
+#define FIXED_MAX_COORD     4 // corners must be inside +-4
+#define FIXED_LANE_BITS    28 // limb width of the vector kernels, a column of products fits 64 bits
+// vector limbs holding at least the bits of limbs GMP limbs
+#define FIXED_LANE_LIMBS(limbs) (((limbs) * GMP_NUMB_BITS + FIXED_LANE_BITS - 1) / FIXED_LANE_BITS)
+
+// what a kernel needs to get its mpfr inputs into fixed point, one per worker made
+// with the worker's other mpfr state.  z is given room for the widest value at the
+// precision up front, so neither it nor t is ever grown (or freed) by a kernel
+struct FixedScratch { mpfr_t t; mpz_t z; };
+typedef struct FixedScratch FixedScratch;
+
+void fixed_scratch_init(FixedScratch *scratch, const int precision);
+void fixed_scratch_clear(FixedScratch *scratch);
+
+// iteration counts for the count pixels starting at column x0 of a row, pixel Dx
+// is at (Xs + Dx*dx, y0).  the same as escape_row_fn but with the mpfr values,
+// they are rounded to fixed point once per call and x steps by a fixed point add.
+// the cycle check's tolerance is a power of two, 2^eps_exp, and 0 leaves it off
+typedef void (*fixed_row_fn)(
+                        mpfr_srcptr Xs,
+                        mpfr_srcptr dx,
+                        const unsigned int x0,
+                        const unsigned int count,
+                        mpfr_srcptr y0,
+                        const unsigned int maxiter,
+                        const long eps_exp,
+                        unsigned int *iterations,
+                        FixedScratch *scratch);
+
+// the same for count pixels down a column from row y0, pixel Dy is at (x0, Ys + Dy*dy)
+// with each y worked out in mpfr as the rows have theirs
+typedef void (*fixed_column_fn)(
+                        mpfr_srcptr x0,
+                        mpfr_srcptr Ys,
+                        mpfr_srcptr dy,
+                        const unsigned int y0,
+                        const unsigned int count,
+                        const unsigned int maxiter,
+                        const long eps_exp,
+                        unsigned int *iterations,
+                        FixedScratch *scratch);
+
+// limbs for a frame computed at precision bits, the same number mpfr would use
+// for its mantissa (the top FIXED_INTEGER_BITS of them go on the integer part),
+// never fewer than FIXED_MIN_LIMBS.  above FIXED_MAX_LIMBS there is no kernel
+int fixed_limbs(const int precision);
+// true if a view with these corners can be run in fixed point
+bool fixed_point_fits(mpfr_srcptr Xs, mpfr_srcptr Xe, mpfr_srcptr Ys, mpfr_srcptr Ye);
+// the row kernel instantiated for limbs, FIXED_MIN_LIMBS..FIXED_MAX_LIMBS, run one
+// pixel at a time (SIMD_SCALAR) or across the vector lanes of level.  level must not
+// be wider than simd_best_level()
+fixed_row_fn fixed_escape_row(const int limbs, const SimdLevel level = SIMD_SCALAR);
+fixed_row_fn fixed_escape_row_avx2(const int limbs);
+fixed_row_fn fixed_escape_row_avx512(const int limbs);
+// and the column kernel, the same way
+fixed_column_fn fixed_escape_column(const int limbs, const SimdLevel level = SIMD_SCALAR);
+fixed_column_fn fixed_escape_column_avx2(const int limbs);
+fixed_column_fn fixed_escape_column_avx512(const int limbs);
+
+// for the vector kernels, n FIXED_LANE_BITS limbs, two's complement, least significant
+// first: the first pixel Xs + x0*dx, the spacing dx and the row's y0
+void fixed_lane_row(int64_t *start, int64_t *step, int64_t *y, const int n,
+                    mpfr_srcptr Xs, mpfr_srcptr dx, const unsigned int x0, mpfr_srcptr y0,
+                    FixedScratch *scratch);
+// a += b, carried so every limb but the top one is in [0, 2^FIXED_LANE_BITS)
+void fixed_lane_add(int64_t *a, const int64_t *b, const int n);
+// v alone, as n limbs
+void fixed_lane_value(int64_t *d, const int n, mpfr_srcptr v, FixedScratch *scratch);
+
+#endif /* ESCAPE_TIME_FIXED_H */
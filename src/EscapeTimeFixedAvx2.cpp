@@ -0,0 +1,58 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// EscapeTimeFixedAvx2.cpp
+
+// the fixed point kernels 4 pixels per instruction, built with -mavx2 (see the Makefile)
+// and only called once simd_best_level() has seen avx2 on the cpu
+
+#include "EscapeTimeFixed.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#include "EscapeTimeFixedLanes.h"
+
+// ----------------------------------------------------------------------------
+// the vector operations escape_row_lanes needs on 4 64 bit lanes.  avx2 has no
+// 64 bit arithmetic shift, it is put together from the logical one and the sign
+//
+struct LanesAvx2
+{
+    typedef __m256i reg;
+    enum { LANES = 4 };
+
+    static reg zero() { return _mm256_setzero_si256(); }
+    static reg set1(const int64_t v) { return _mm256_set1_epi64x(v); }
+    static reg lane() { return _mm256_set_epi64x(3, 2, 1, 0); }
+    static reg load(const int64_t *p) { return _mm256_loadu_si256((const __m256i*)p); }
+    static void store(int64_t *p, const reg a) { _mm256_storeu_si256((__m256i*)p, a); }
+    static reg add(const reg a, const reg b) { return _mm256_add_epi64(a, b); }
+    static reg sub(const reg a, const reg b) { return _mm256_sub_epi64(a, b); }
+    static reg and_(const reg a, const reg b) { return _mm256_and_si256(a, b); }
+    static reg or_(const reg a, const reg b) { return _mm256_or_si256(a, b); }
+    static reg xor_(const reg a, const reg b) { return _mm256_xor_si256(a, b); }
+    // low 32 bits of each lane, multiplied out to 64
+    static reg mul32(const reg a, const reg b) { return _mm256_mul_epu32(a, b); }
+    template<int K> static reg srli(const reg a) { return _mm256_srli_epi64(a, K); }
+    template<int K> static reg slli(const reg a) { return _mm256_slli_epi64(a, K); }
+    template<int K> static reg srai(const reg a)
+    {
+        return _mm256_or_si256(_mm256_srli_epi64(a, K), _mm256_slli_epi64(_mm256_cmpgt_epi64(zero(), a), 64 - K));
+    }
+    // all ones in the lanes where it holds
+    static reg cmpgt(const reg a, const reg b) { return _mm256_cmpgt_epi64(a, b); }
+    static reg cmpeq(const reg a, const reg b) { return _mm256_cmpeq_epi64(a, b); }
+    static bool any(const reg a) { return !_mm256_testz_si256(a, a); }
+};
+
+// ----------------------------------------------------------------------------
+fixed_row_fn fixed_escape_row_avx2(const int limbs)
+{
+    return lanes_kernel<LanesAvx2>(limbs);
+}
+
+// ----------------------------------------------------------------------------
+fixed_column_fn fixed_escape_column_avx2(const int limbs)
+{
+    return lanes_column_kernel<LanesAvx2>(limbs);
+}
+
+#endif
@@ -0,0 +1,58 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// EscapeTimeFixedAvx512.cpp
+
+// the fixed point kernels 8 pixels per instruction, built with -mavx512f (see the
+// Makefile) and only called once simd_best_level() has seen avx512 on the cpu
+
+#include "EscapeTimeFixed.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#include "EscapeTimeFixedLanes.h"
+
+// ----------------------------------------------------------------------------
+// the vector operations escape_row_lanes needs on 8 64 bit lanes.  compares give
+// a mask register, they are spread back out to all ones lanes as avx2 has them
+//
+struct LanesAvx512
+{
+    typedef __m512i reg;
+    enum { LANES = 8 };
+
+    static reg zero() { return _mm512_setzero_si512(); }
+    static reg set1(const int64_t v) { return _mm512_set1_epi64(v); }
+    static reg lane() { return _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0); }
+    static reg load(const int64_t *p) { return _mm512_loadu_si512((const void*)p); }
+    static void store(int64_t *p, const reg a) { _mm512_storeu_si512((void*)p, a); }
+    static reg add(const reg a, const reg b) { return _mm512_add_epi64(a, b); }
+    static reg sub(const reg a, const reg b) { return _mm512_sub_epi64(a, b); }
+    static reg and_(const reg a, const reg b) { return _mm512_and_si512(a, b); }
+    static reg or_(const reg a, const reg b) { return _mm512_or_si512(a, b); }
+    static reg xor_(const reg a, const reg b) { return _mm512_xor_si512(a, b); }
+    // low 32 bits of each lane, multiplied out to 64.  the maskz form with every lane
+    // set, gcc 12 warns about the undefined pass through operand of the plain one
+    static reg mul32(const reg a, const reg b) { return _mm512_maskz_mul_epu32((__mmask8)0xff, a, b); }
+    // the shifts as vector operators for the same reason, they are the same vpsrlq,
+    // vpsllq and vpsraq
+    template<int K> static reg srli(const reg a) { return (reg)((__v8du)a >> K); }
+    template<int K> static reg slli(const reg a) { return a << K; }
+    template<int K> static reg srai(const reg a) { return a >> K; }
+    // all ones in the lanes where it holds
+    static reg cmpgt(const reg a, const reg b) { return _mm512_maskz_set1_epi64(_mm512_cmpgt_epi64_mask(a, b), -1); }
+    static reg cmpeq(const reg a, const reg b) { return _mm512_maskz_set1_epi64(_mm512_cmpeq_epi64_mask(a, b), -1); }
+    static bool any(const reg a) { return _mm512_test_epi64_mask(a, a) != 0; }
+};
+
+// ----------------------------------------------------------------------------
+fixed_row_fn fixed_escape_row_avx512(const int limbs)
+{
+    return lanes_kernel<LanesAvx512>(limbs);
+}
+
+// ----------------------------------------------------------------------------
+fixed_column_fn fixed_escape_column_avx512(const int limbs)
+{
+    return lanes_column_kernel<LanesAvx512>(limbs);
+}
+
+#endif
@@ -0,0 +1,319 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// EscapeTimeFixedLanes.h
+
+// the fixed point escape time loop for several pixels at once, only included by the
+// files built with the wider instruction sets (EscapeTimeFixedAvx2.cpp, 4 pixels, and
+// EscapeTimeFixedAvx512.cpp, 8 pixels), which supply V, the vector operations.
+//
+// a number is held structure of arrays: vector register k holds limb k of every lane.
+// there is no 64x64 bit multiply across lanes, only 32x32 -> 64 (vpmuludq), so the
+// limbs are FIXED_LANE_BITS wide, two's complement, in 64 bit lanes.  a product of two
+// limbs is under 2^56 and a whole column of a square adds up in its lane without
+// carrying, the carries are propagated once per square.  the scaling is the scalar
+// kernel's, FIXED_INTEGER_BITS above the point, so the top limb holds the sign, the
+// integer bits and FIXED_LANE_BITS - FIXED_INTEGER_BITS bits of fraction.
+//
+// a lane that escapes is masked off and its count stops, its z carries on as garbage
+// (nothing in integer vector arithmetic traps) until every lane has escaped.
+
+#ifndef ESCAPE_TIME_FIXED_LANES_H
+#define ESCAPE_TIME_FIXED_LANES_H
+
+#include <stdint.h>
+#include <utility>
+#include <gmp.h>
+#include <mpfr.h>
+#include "EscapeTimeFixed.h"
+
+#define FIXED_LANE_MASK (((int64_t)1 << FIXED_LANE_BITS) - 1)
+#define FIXED_LANE_TOP  (FIXED_LANE_BITS - FIXED_INTEGER_BITS) // fraction bits in the top limb
+
+// ----------------------------------------------------------------------------
+// carry every limb into the one above so all but the top one are in
+// [0, 2^FIXED_LANE_BITS)
+//
+template<typename V, int N>
+static inline void lanes_normalize(typename V::reg *a)
+{
+    const typename V::reg mask = V::set1(FIXED_LANE_MASK);
+    for (int k = 0; k < N - 1; k++)
+    {
+        a[k + 1] = V::add(a[k + 1], V::template srai<FIXED_LANE_BITS>(a[k]));
+        a[k] = V::and_(a[k], mask);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// r = |a|, a normalized.  negating every limb of the negative lanes and carrying
+// again is the two's complement negation
+//
+template<typename V, int N>
+static inline void lanes_abs(typename V::reg *r, const typename V::reg *a)
+{
+    const typename V::reg negative = V::cmpgt(V::zero(), a[N - 1]);
+    for (int k = 0; k < N; k++)
+    {
+        r[k] = V::sub(V::xor_(a[k], negative), negative);
+    }
+    lanes_normalize<V, N>(r);
+}
+
+// ----------------------------------------------------------------------------
+// r = a*a for a normalized and not negative.  each column of the product is
+// twice the a[i]*a[j], i < j, plus a[c/2]^2, and only the columns from N-2 up
+// are formed, the ones below could carry less than N units into the last bit
+// kept.  then the columns are carried and shifted down FIXED_LANE_TOP bits
+// into place, the bits under the point dropped
+//
+template<typename V, int N>
+static inline void lanes_sqr(typename V::reg *r, const typename V::reg *a)
+{
+    const typename V::reg mask = V::set1(FIXED_LANE_MASK);
+    typename V::reg twice[N];
+    typename V::reg col[N + 1]; // columns N-2 .. 2N-2
+
+    for (int k = 0; k < N; k++)
+    {
+        twice[k] = V::add(a[k], a[k]);
+    }
+    for (int c = N - 2; c <= 2 * N - 2; c++)
+    {
+        typename V::reg acc = V::zero();
+        for (int i = (c - (N - 1) > 0) ? c - (N - 1) : 0; i < c - i; i++)
+        {
+            acc = V::add(acc, V::mul32(twice[i], a[c - i]));
+        }
+        if ((c & 1) == 0) {
+            acc = V::add(acc, V::mul32(a[c / 2], a[c / 2]));
+        }
+        col[c - (N - 2)] = acc;
+    }
+    for (int c = 0; c < N; c++)
+    {
+        col[c + 1] = V::add(col[c + 1], V::template srli<FIXED_LANE_BITS>(col[c]));
+        col[c] = V::and_(col[c], mask);
+    }
+    for (int k = 0; k < N - 1; k++)
+    {
+        r[k] = V::or_(V::template srli<FIXED_LANE_TOP>(col[k + 1]),
+                      V::and_(V::template slli<FIXED_INTEGER_BITS>(col[k + 2]), mask));
+    }
+    r[N - 1] = V::template srli<FIXED_LANE_TOP>(col[N]);
+}
+
+// ----------------------------------------------------------------------------
+// all ones in the lanes where |a - b| < 2^eps_exp, near[k] masking the bits of
+// limb k that must be clear
+//
+template<typename V, int N>
+static inline typename V::reg lanes_within(const typename V::reg *a, const typename V::reg *b,
+                                           const typename V::reg *near)
+{
+    typename V::reg d[N];
+    for (int k = 0; k < N; k++) { d[k] = V::sub(a[k], b[k]); }
+    lanes_normalize<V, N>(d);
+    lanes_abs<V, N>(d, d);
+    typename V::reg high = V::zero();
+    for (int k = 0; k < N; k++) { high = V::or_(high, V::and_(d[k], near[k])); }
+    return V::cmpeq(high, V::zero());
+}
+
+// ----------------------------------------------------------------------------
+// lanes_near - the masks lanes_within tests |a - b| < 2^eps_exp with, the bits
+// from N*FIXED_LANE_BITS - FIXED_INTEGER_BITS + eps_exp up
+//
+template<typename V, int N>
+static inline void lanes_near(typename V::reg *near, const long eps_exp)
+{
+    long b = (long)N * FIXED_LANE_BITS - FIXED_INTEGER_BITS + eps_exp;
+    b = (b < 0) ? 0 : b;
+    for (int k = 0; k < N; k++)
+    {
+        long bit = b - (long)k * FIXED_LANE_BITS;
+        near[k] = V::set1((bit <= 0) ? -1 : (bit >= FIXED_LANE_BITS) ? 0 : (int64_t)(~(uint64_t)0 << bit));
+    }
+}
+
+// ----------------------------------------------------------------------------
+// lanes_escape - fixed_escape for V::LANES pixels at a time, the same steps (the
+// cross term from (x+y)^2) so the counts agree with the scalar kernel but for the
+// bits the two drop.  every active lane has done the same number of iterations,
+// so the cycle check saves z for all of them at once.  the counts of the first n
+// lanes go to iterations
+//
+template<typename V, int N>
+static inline void lanes_escape(const typename V::reg *cx, const typename V::reg *cy, const unsigned int n,
+                                const unsigned int maxiter, const long eps_exp, const typename V::reg *near,
+                                unsigned int *iterations)
+{
+    typedef typename V::reg reg;
+    const reg four = V::set1((int64_t)4 << FIXED_LANE_TOP);
+    const reg one = V::set1(1);
+    const reg vmaxiter = V::set1(maxiter);
+    int64_t counts[V::LANES];
+    reg x[N], y[N], X[N], Y[N], S[N], t[N], sum[N], xs[N], ys[N];
+
+    for (int k = 0; k < N; k++)
+    {
+        x[k] = y[k] = sum[k] = xs[k] = ys[k] = V::zero();
+    }
+    reg active = V::cmpgt(V::set1(n), V::lane());
+    reg iteration = V::zero();
+    unsigned int save = 1;
+
+    for (unsigned int it = 0; it < maxiter; it++)
+    {
+        // xsq + ysq <= 4, 4 is all in the top limb
+        reg low = V::zero();
+        for (int k = 0; k < N - 1; k++) { low = V::or_(low, sum[k]); }
+        active = V::and_(active, V::or_(V::cmpgt(four, sum[N - 1]),
+                                         V::and_(V::cmpeq(four, sum[N - 1]), V::cmpeq(low, V::zero()))));
+        if (!V::any(active)) {
+            break;
+        }
+
+        lanes_abs<V, N>(t, x);
+        lanes_sqr<V, N>(X, t);                                      // xsq = x*x
+        lanes_abs<V, N>(t, y);
+        lanes_sqr<V, N>(Y, t);                                      // ysq = y*y
+        for (int k = 0; k < N; k++) { t[k] = V::add(x[k], y[k]); }
+        lanes_normalize<V, N>(t);
+        lanes_abs<V, N>(t, t);
+        lanes_sqr<V, N>(S, t);                                      // (x+y)^2
+        for (int k = 0; k < N; k++)
+        {
+            sum[k] = V::add(X[k], Y[k]);                            // xsq + ysq
+            y[k] = V::add(V::sub(S[k], sum[k]), cy[k]);             // y = 2*x*y + y0
+            x[k] = V::add(V::sub(X[k], Y[k]), cx[k]);               // x = xsq - ysq + x0
+        }
+        lanes_normalize<V, N>(sum);
+        lanes_normalize<V, N>(y);
+        lanes_normalize<V, N>(x);
+        iteration = V::add(iteration, V::and_(active, one));
+
+        if (eps_exp != 0) {
+            reg cycled = V::and_(active, V::and_(lanes_within<V, N>(x, xs, near), lanes_within<V, N>(y, ys, near)));
+            if (V::any(cycled)) {
+                iteration = V::xor_(iteration, V::and_(cycled, V::xor_(iteration, vmaxiter)));
+                active = V::xor_(active, cycled);
+            }
+            if (it + 1 == save) {
+                for (int k = 0; k < N; k++) { xs[k] = x[k]; ys[k] = y[k]; }
+                save *= 2;
+            }
+        }
+    }
+
+    V::store(counts, iteration);
+    for (unsigned int l = 0; l < n; l++)
+    {
+        iterations[l] = (unsigned int)counts[l];
+    }
+}
+
+// ----------------------------------------------------------------------------
+// escape_row_lanes - the fixed_row_fn, V::LANES pixels of the row at a time
+//
+template<typename V, int LIMBS>
+static void escape_row_lanes(mpfr_srcptr Xs, mpfr_srcptr dx, const unsigned int x0, const unsigned int count,
+                             mpfr_srcptr y0, const unsigned int maxiter, const long eps_exp, unsigned int *iterations,
+                             FixedScratch *scratch)
+{
+    typedef typename V::reg reg;
+    const int N = FIXED_LANE_LIMBS(LIMBS);
+    int64_t start[N], step[N], ci[N], lanes[N][V::LANES];
+    reg cx[N], cy[N], stride[N], near[N];
+
+    lanes_near<V, N>(near, eps_exp);
+
+    // the first V::LANES pixels, then every batch is V::LANES*dx on from the last
+    fixed_lane_row(start, step, ci, N, Xs, dx, x0, y0, scratch);
+    for (int l = 0; l < V::LANES; l++)
+    {
+        for (int k = 0; k < N; k++) { lanes[k][l] = start[k]; }
+        fixed_lane_add(start, step, N);
+    }
+    for (int k = 0; k < N; k++)
+    {
+        cx[k] = V::load(lanes[k]);
+        cy[k] = V::set1(ci[k]);
+        stride[k] = V::set1(step[k] * V::LANES);
+    }
+    lanes_normalize<V, N>(stride);
+
+    for (unsigned int i = 0; i < count; i += V::LANES)
+    {
+        unsigned int n = (count - i < V::LANES) ? count - i : V::LANES;
+        lanes_escape<V, N>(cx, cy, n, maxiter, eps_exp, near, iterations + i);
+        for (int k = 0; k < N; k++) { cx[k] = V::add(cx[k], stride[k]); }
+        lanes_normalize<V, N>(cx);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// escape_column_lanes - the fixed_column_fn, V::LANES pixels of the column at a
+// time.  each pixel's y is worked out in mpfr as the rows have theirs
+//
+template<typename V, int LIMBS>
+static void escape_column_lanes(mpfr_srcptr x0, mpfr_srcptr Ys, mpfr_srcptr dy, const unsigned int y0,
+                                const unsigned int count, const unsigned int maxiter, const long eps_exp,
+                                unsigned int *iterations, FixedScratch *scratch)
+{
+    typedef typename V::reg reg;
+    const int N = FIXED_LANE_LIMBS(LIMBS);
+    int64_t ci[N], lanes[N][V::LANES];
+    reg cx[N], cy[N], near[N];
+
+    lanes_near<V, N>(near, eps_exp);
+    fixed_lane_value(ci, N, x0, scratch);
+    for (int k = 0; k < N; k++) { cx[k] = V::set1(ci[k]); }
+
+    for (unsigned int i = 0; i < count; i += V::LANES)
+    {
+        unsigned int n = (count - i < V::LANES) ? count - i : V::LANES;
+        for (unsigned int l = 0; l < V::LANES; l++)
+        {
+            if (l < n) {
+                mpfr_mul_ui(scratch->t, dy, y0 + i + l, MPFR_RNDN);
+                mpfr_add(scratch->t, scratch->t, Ys, MPFR_RNDN);
+                fixed_lane_value(ci, N, scratch->t, scratch);
+            }
+            for (int k = 0; k < N; k++) { lanes[k][l] = (l < n) ? ci[k] : 0; }
+        }
+        for (int k = 0; k < N; k++) { cy[k] = V::load(lanes[k]); }
+        lanes_escape<V, N>(cx, cy, n, maxiter, eps_exp, near, iterations + i);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// one kernel per limb count, FIXED_MIN_LIMBS first
+//
+template<typename V, int... L>
+static const fixed_row_fn* lanes_kernels(std::integer_sequence<int, L...>)
+{
+    static const fixed_row_fn kernels[] = { escape_row_lanes<V, L + FIXED_MIN_LIMBS>... };
+    return kernels;
+}
+
+template<typename V, int... L>
+static const fixed_column_fn* lanes_column_kernels(std::integer_sequence<int, L...>)
+{
+    static const fixed_column_fn kernels[] = { escape_column_lanes<V, L + FIXED_MIN_LIMBS>... };
+    return kernels;
+}
+
+template<typename V>
+static fixed_row_fn lanes_kernel(const int limbs)
+{
+    return lanes_kernels<V>(std::make_integer_sequence<int, FIXED_MAX_LIMBS - FIXED_MIN_LIMBS + 1>())
+           [limbs - FIXED_MIN_LIMBS];
+}
+
+template<typename V>
+static fixed_column_fn lanes_column_kernel(const int limbs)
+{
+    return lanes_column_kernels<V>(std::make_integer_sequence<int, FIXED_MAX_LIMBS - FIXED_MIN_LIMBS + 1>())
+           [limbs - FIXED_MIN_LIMBS];
+}
+
+#endif /* ESCAPE_TIME_FIXED_LANES_H */
@@ -0,0 +1,146 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// EscapeTimeSimd.cpp
+
+// the scalar kernels and the choice between them and the vector ones, which live in
+// their own files so only they are built with the wider instruction sets
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#include "EscapeTimeSimd.h"
+#include "EscapeTime.h"
+
+// environment variable that forces a level, eg MANDELBROT_SIMD=avx2
+#define SIMD_ENV_VAR "MANDELBROT_SIMD"
+
+// ----------------------------------------------------------------------------
+// escape_row_scalar - the fallback, calculate_point<double> one pixel at a time
+//
+void escape_row_scalar(const double Xs, const double dx, const unsigned int x0, const unsigned int count,
+                       const double y0, const unsigned int maxiter, const double eps, unsigned int *iterations)
+{
+    for (unsigned int i = 0; i < count; i++)
+    {
+        iterations[i] = calculate_point<double>(Xs + (double)(x0 + i) * dx, y0, maxiter, eps);
+    }
+}
+
+// ----------------------------------------------------------------------------
+void escape_column_scalar(const double x0, const double *y0, const unsigned int count,
+                          const unsigned int maxiter, const double eps, unsigned int *iterations)
+{
+    for (unsigned int i = 0; i < count; i++)
+    {
+        iterations[i] = calculate_point<double>(x0, y0[i], maxiter, eps);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// detect_level - ask cpuid what the cpu has and xgetbv whether the OS saves the
+// ymm (and for avx512 the zmm/mask) registers across context switches, a cpu
+// with avx512f under an OS that doesn't can't use it
+//
+static SimdLevel detect_level()
+{
+    SimdLevel level = SIMD_SCALAR;
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax, ebx, ecx, edx;
+    unsigned int xcr0_lo, xcr0_hi;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) {
+        return SIMD_SCALAR;
+    }
+    __asm__ ("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    if ((xcr0_lo & 0x06) != 0x06) { // sse and avx state
+        return SIMD_SCALAR;
+    }
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return SIMD_SCALAR;
+    }
+    if (ebx & bit_AVX2) {
+        level = SIMD_AVX2;
+    }
+    if ((ebx & bit_AVX512F) && (xcr0_lo & 0xe6) == 0xe6) { // plus opmask and zmm state
+        level = SIMD_AVX512;
+    }
+#endif
+    return level;
+}
+
+// ----------------------------------------------------------------------------
+// the cpu is only asked once, the first time a level is needed
+//
+SimdLevel simd_best_level()
+{
+    static const SimdLevel best = detect_level();
+    return best;
+}
+
+// ----------------------------------------------------------------------------
+// simd_default_level - simd_best_level() unless MANDELBROT_SIMD names another
+// level (scalar, avx2 or avx512), a level the cpu can't run falls back to the best
+//
+SimdLevel simd_default_level()
+{
+    SimdLevel best = simd_best_level();
+    const char *forced = getenv(SIMD_ENV_VAR);
+    if (forced == NULL || forced[0] == '\0') {
+        return best;
+    }
+
+    for (int level = SIMD_SCALAR; level <= SIMD_AVX512; level++)
+    {
+        if (strcmp(forced, simd_level_name((SimdLevel)level)) != 0) {
+            continue;
+        }
+        if (level > best) {
+            std::cout << SIMD_ENV_VAR << "=" << forced << " is not supported by this cpu\n";
+            return best;
+        }
+        return (SimdLevel)level;
+    }
+    std::cout << SIMD_ENV_VAR << "=" << forced << " is not a simd level (scalar, avx2, avx512)\n";
+    return best;
+}
+
+// ----------------------------------------------------------------------------
+escape_row_fn simd_escape_row(const SimdLevel level)
+{
+    switch (level)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        case SIMD_AVX512: return escape_row_avx512;
+        case SIMD_AVX2:   return escape_row_avx2;
+#endif
+        default:          return escape_row_scalar;
+    }
+}
+
+// ----------------------------------------------------------------------------
+escape_column_fn simd_escape_column(const SimdLevel level)
+{
+    switch (level)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        case SIMD_AVX512: return escape_column_avx512;
+        case SIMD_AVX2:   return escape_column_avx2;
+#endif
+        default:          return escape_column_scalar;
+    }
+}
+
+// ----------------------------------------------------------------------------
+const char* simd_level_name(const SimdLevel level)
+{
+    switch (level)
+    {
+        case SIMD_AVX512: return "avx512";
+        case SIMD_AVX2:   return "avx2";
+        default:          return "scalar";
+    }
+}
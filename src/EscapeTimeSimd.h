@@ -0,0 +1,62 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// EscapeTimeSimd.h
+
+// the double escape time loop run across a run of pixels of one row (or column) at a
+// time, either one pixel at a time (scalar) or 4 (AVX2) / 8 (AVX-512) pixels per
+// instruction.
+// every version does the same operations in the same order as calculate_point<double>
+// so they give the same iteration counts, the vector ones just mask lanes off as
+// their pixels escape.
+
+#ifndef ESCAPE_TIME_SIMD_H
+#define ESCAPE_TIME_SIMD_H
+
+// instruction set the double tier runs its rows with, widest last
+enum SimdLevel { SIMD_SCALAR, SIMD_AVX2, SIMD_AVX512 };
+
+// iteration counts for the count pixels starting at column x0 of a row, pixel Dx
+// is at (Xs + Dx*dx, y0).  eps > 0 turns on calculate_point's cycle check
+typedef void (*escape_row_fn)(
+                        const double Xs, 
+                        const double dx, 
+                        const unsigned int x0, 
+                        const unsigned int count, 
+                        const double y0, 
+                        const unsigned int maxiter, 
+                        const double eps,
+                        unsigned int *iterations);
+
+void escape_row_scalar(const double Xs, const double dx, const unsigned int x0, const unsigned int count,
+                       const double y0, const unsigned int maxiter, const double eps, unsigned int *iterations);
+void escape_row_avx2(const double Xs, const double dx, const unsigned int x0, const unsigned int count,
+                     const double y0, const unsigned int maxiter, const double eps, unsigned int *iterations);
+void escape_row_avx512(const double Xs, const double dx, const unsigned int x0, const unsigned int count,
+                       const double y0, const unsigned int maxiter, const double eps, unsigned int *iterations);
+
+// the same for count pixels down a column, pixel i is at (x0, y0[i])
+typedef void (*escape_column_fn)(
+                        const double x0, 
+                        const double *y0, 
+                        const unsigned int count, 
+                        const unsigned int maxiter, 
+                        const double eps,
+                        unsigned int *iterations);
+
+void escape_column_scalar(const double x0, const double *y0, const unsigned int count,
+                          const unsigned int maxiter, const double eps, unsigned int *iterations);
+void escape_column_avx2(const double x0, const double *y0, const unsigned int count,
+                        const unsigned int maxiter, const double eps, unsigned int *iterations);
+void escape_column_avx512(const double x0, const double *y0, const unsigned int count,
+                          const unsigned int maxiter, const double eps, unsigned int *iterations);
+
+// widest level this cpu can run, from cpuid
+SimdLevel simd_best_level();
+// level a new MandelbrotMpfr starts with, simd_best_level() unless the
+// MANDELBROT_SIMD environment variable forces a lower one
+SimdLevel simd_default_level();
+// the row and column kernels for level, level must not be wider than simd_best_level()
+escape_row_fn simd_escape_row(const SimdLevel level);
+escape_column_fn simd_escape_column(const SimdLevel level);
+const char* simd_level_name(const SimdLevel level);
+
+#endif /* ESCAPE_TIME_SIMD_H */
@@ -0,0 +1,133 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// FloatExp.h
+
+// floatexp - a double mantissa with its own 64 bit exponent.  it has the 53 bits of
+// precision of a double but (for our purposes) no limit on range, so perturbation
+// deltas can be held past the 1e-308 where a double underflows.  it plugs into the
+// kernels as a template argument in place of double, T(4), T(2)*x and so on.
+//
+// the value is m * 2^e with 0.5 <= |m| < 1 (or m = 0, e = 0).  within the range of a
+// double every operation rounds the same way the double operation would.
+
+#ifndef FLOAT_EXP_H
+#define FLOAT_EXP_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#define FLOATEXP_EXP_MASK 0x7ff0000000000000ULL
+#define FLOATEXP_EXP_HALF 0x3fe0000000000000ULL // exponent field of [0.5, 1)
+
+class floatexp
+{
+  public:
+    floatexp() : m(0.0), e(0) {}
+    floatexp(const double v) : m(v), e(0) { normalise(); }
+    floatexp(const int v) : m((double)v), e(0) { normalise(); }
+    // mant * 2^exp, eg straight from mpfr_get_d_2exp
+    floatexp(const double mant, const int64_t exp) : m(mant), e(exp) { normalise(); }
+
+    // nearest double, 0 or inf outside its range
+    explicit operator double() const 
+    {
+        if (e > 1100) { return m * INFINITY; }
+        if (e < -1100) { return m * 0.0; }
+        return ldexp(m, (int)e);
+    }
+
+    double mantissa() const { return m; }
+    int64_t exponent() const { return e; }
+
+    floatexp operator-() const { floatexp r; r.m = -m; r.e = e; return r; }
+
+    friend floatexp operator*(const floatexp &a, const floatexp &b)
+    {
+        floatexp r;
+        r.m = a.m * b.m;
+        r.e = a.e + b.e;
+        r.normalise();
+        return r;
+    }
+
+    friend floatexp operator+(const floatexp &a, const floatexp &b)
+    {
+        // the smaller is shifted down to the larger's exponent, past 64 bits it
+        // can no longer change the rounded result
+        if (b.m == 0.0) { return a; }
+        if (a.m == 0.0) { return b; }
+        int64_t d = a.e - b.e;
+        floatexp r;
+        if (d >= 0) {
+            if (d > 64) { return a; }
+            r.m = a.m + b.m * pow2(-d);
+            r.e = a.e;
+        } else {
+            if (d < -64) { return b; }
+            r.m = a.m * pow2(d) + b.m;
+            r.e = b.e;
+        }
+        r.normalise();
+        return r;
+    }
+
+    friend floatexp operator-(const floatexp &a, const floatexp &b) { return a + (-b); }
+
+    friend bool operator<=(const floatexp &a, const floatexp &b) { return !(b < a); }
+    friend bool operator<(const floatexp &a, const floatexp &b)
+    {
+        // 0.5 <= |m| < 1, so between numbers of one sign the exponent decides first
+        if ((a.m < 0.0) != (b.m < 0.0) || a.m == 0.0 || b.m == 0.0) { return a.m < b.m; }
+        if (a.e == b.e) { return a.m < b.m; }
+        return (a.m > 0.0) ? (a.e < b.e) : (a.e > b.e);
+    }
+
+    friend floatexp abs(const floatexp &a) { return (a.m < 0.0) ? -a : a; }
+    friend floatexp sqrt(const floatexp &a)
+    {
+        // halve an even exponent, m * 2^e = (2m) * 2^(e-1) when e is odd
+        floatexp r;
+        if (a.e % 2 == 0) {
+            r.m = ::sqrt(a.m);
+            r.e = a.e / 2;
+        } else {
+            r.m = ::sqrt(2.0 * a.m);
+            r.e = (a.e - 1) / 2;
+        }
+        r.normalise();
+        return r;
+    }
+
+  private:
+    // 2^d for -64 <= d <= 0, built straight into the exponent field
+    static double pow2(const int64_t d)
+    {
+        uint64_t bits = (uint64_t)(1023 + d) << 52;
+        double r;
+        memcpy(&r, &bits, sizeof(r));
+        return r;
+    }
+
+    // move the binary exponent of m into e, leaving m in [0.5, 1)
+    void normalise()
+    {
+        uint64_t bits;
+        memcpy(&bits, &m, sizeof(bits));
+        uint64_t field = bits & FLOATEXP_EXP_MASK;
+        if (field == 0) {
+            if (m == 0.0) { e = 0; return; }
+            int shift;
+            m = frexp(m, &shift); // subnormal mantissa, rare
+            e += shift;
+            return;
+        }
+        e += (int64_t)(field >> 52) - 1022;
+        bits = (bits & ~FLOATEXP_EXP_MASK) | FLOATEXP_EXP_HALF;
+        memcpy(&m, &bits, sizeof(m));
+    }
+
+    double m;
+    int64_t e;
+};
+
+#endif /* FLOAT_EXP_H */
@@ -24,9 +24,35 @@ MandelbrotAdapter::MandelbrotAdapter(CmdOptions *options)
   m_factor = options->getFactor();
 
   //setup_c();
+  mpfr = new MandelbrotMpfr(0, m_maxiter, m_factor); //precision. maxiter, zoom_factor
+  if (options->getAlgo() == ALGO_FIXED) {
+    useFixedPoint();
+  }
+  else if (options->getAlgo() == ALGO_PERTURBATION) {
+    usePerturbation();
+  }
+  else if (options->getAlgo() == ALGO_BLA) {
+    useBla();
+  }
+  if (options->getGlitchFix() == GLITCHFIX_REFERENCES) {
+    useGlitchMode(GLITCH_REFERENCES);
+  }
+  else if (options->getGlitchFix() == GLITCHFIX_NONE) {
+    useGlitchMode(GLITCH_NONE);
+  }
+  if (options->getCacheDir() != "") {
+    mpfr->setOrbitCache(options->getCacheDir(), (size_t)options->getCacheSize() * 1024 * 1024);
+  }
+  if (options->getSubdivide()) {
+    mpfr->setUseSubdivision(true);
+  }
   reset(options->getReal(), options->getImag());
-  mpfr = new MandelbrotMpfr(0, m_maxiter, 0); //precision. maxiter, zoom_factor
-  
+
+  // a fixed centre zoom of known length can have its reference orbit at the precision 
+  // of the last frame from the start
+  if (m_fixedCentre && (options->getFrames() > 1)) {
+    mpfr->planZoomSequence(options->getFrames() - 1, m_width);
+  }
 }
 
 // PUBLIC METHODS -------------------------------------------------------------------------
@@ -61,13 +87,39 @@ void MandelbrotAdapter::cleanUp()
 }
 
 // ---------------------------------------------------------------------------------------
-// pixels char array is allocated here, caller is responsible for freeing it.
+// pixels char array belongs to imageData, the workers write the frame straight into it.
 void MandelbrotAdapter::getTextureData(ImageData *imageData)
 {
   unsigned char *pixels = NULL;
   imageData->getByteArray(&pixels);
 
   mpfr->mandelbrot_mpfr_c(m_width, m_height, &pixels);
+  std::cout << "frame " << m_framecount << " tier " << MandelbrotMpfr::tierName(mpfr->getFrameTier());
+  std::cout << " (" << mpfr->getPixelBits() << " bits per pixel)";
+  if (mpfr->getOrbitReused()) {
+    std::cout << " reference reused";
+  }
+  if (mpfr->getOrbitCached()) {
+    std::cout << " reference loaded from " << mpfr->getOrbitCache()->directory();
+  }
+  if (mpfr->getSeriesSkip() > 0) {
+    std::cout << " series skipped " << mpfr->getSeriesSkip() << " iterations per pixel, ";
+    std::cout << mpfr->getSkippedIterations() << " in all";
+  }
+  if (mpfr->getGlitchReferences() > 0) {
+    std::cout << " " << mpfr->getGlitchedPixels() << " glitched pixels redone against ";
+    std::cout << mpfr->getGlitchReferences() << " more references";
+  }
+  else if (mpfr->getGlitchedPixels() > 0) {
+    std::cout << " " << mpfr->getGlitchedPixels() << " pixels rebased";
+  }
+  if (mpfr->getUnresolvedGlitches() > 0) {
+    std::cout << ", " << mpfr->getUnresolvedGlitches() << " STILL GLITCHED";
+  }
+  if (mpfr->getRejectedPixels() > 0) {
+    std::cout << " " << mpfr->getRejectedPixels() << " pixels in the cardioid or bulb";
+  }
+  std::cout << "\n";
 }
 
 // ---------------------------------------------------------------------------------------
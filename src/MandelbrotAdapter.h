@@ -24,6 +24,11 @@ class MandelbrotAdapter
     void reset();
     void useFixed() { m_fixedCentre = true; }
     void useMouse() { m_fixedCentre = false; }
+    void usePerturbation() { mpfr->setUsePerturbation(true); mpfr->setUseBla(false); }
+    void useBla() { mpfr->setUsePerturbation(true); mpfr->setUseBla(true); }
+    void useMpfr() { mpfr->setUsePerturbation(false); mpfr->setUseBla(false); mpfr->setUseFixedPoint(false); }
+    void useFixedPoint() { useMpfr(); mpfr->setUseFixedPoint(true); }
+    void useGlitchMode(const GlitchMode mode) { mpfr->setGlitchMode(mode); }
     
     void getTextureData(ImageData *imageData);
     void cleanUp();
@@ -35,10 +35,11 @@
 
 #include <iostream>
 #include <vector>
+#include <algorithm>
 #include <cmath>
 #include <cassert>
-
-#include <thread>
+#include <cstring>
+#include <cfloat>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -60,6 +61,11 @@
 #include <mpfr.h>
 
 #include "MandelbrotMpfr.h"
+#include "EscapeTime.h"
+#include "EscapeTimeSimd.h"
+#include "Perturbation.h"
+#include "FloatExp.h"
+#include "QuadDouble.h"
 
 // DEFINES
 
@@ -75,19 +81,51 @@
 #define TRACE_DEBUG(formatstring)
 #endif
 
+// worker_args counts of pixels not yet computed, and of pixels that lost the reference
+#define COUNT_UNSET    0xffffffffu
+#define COUNT_GLITCHED 0xfffffffeu
+
 
 
 // TYPEDEFS 
 struct Color { unsigned char r, g, b; };
 typedef struct Color Color;
-struct worker_args { unsigned int x0, y0, x1, y1, maxiter, precision, tid, cpus; 
-                     mpfr_t Xe, Xs, Ye, Ys; };
+struct worker_args { unsigned int x0, y0, x1, y1, xsize, ysize, maxiter, precision, tid, cpus; 
+                     mpfr_t Xe, Xs, Ye, Ys; 
+                     mpfr_t dx, dy;                         // pixel spacing 
+                     mpfr_t x, y, xsq, ysq, x0r, y0i;       // algorithm values 
+                     mpfr_t a, sum_xsq_ysq;                 // tmp vals 
+                     mpfr_t xs, ys;                         // z saved by the cycle check 
+                     MpfrArena *arena;                      // NULL unless m_useArena 
+                     NumericTier tier;                      // type the frame runs in 
+                     long double Xs_ld, Ys_ld, dx_ld, dy_ld; // corner and spacing for the hardware tiers 
+                     qdouble Xs_qd, Ys_qd, dx_qd, dy_qd;    // and for the double-double and quad-double tiers 
+                     escape_row_fn escape_row;              // double tier kernel for m_simdLevel 
+                     escape_column_fn escape_column;        // and for the columns subdivision asks for 
+                     fixed_row_fn fixed_row;                // TIER_FIXED_POINT kernel for the limbs and m_simdLevel 
+                     fixed_column_fn fixed_column; 
+                     FixedScratch fixed_scratch;            // for the fixed kernels, at m_framePrecision 
+                     ReferenceOrbit *orbit;                 // reference orbit for TIER_PERTURBATION 
+                     floatexp dcx0, dcy0;                   // pixel (0,0) less the reference point 
+                     floatexp dx_fe, dy_fe;                 // spacing, past long double range 
+                     const SeriesApproximation *series;     // start point of every pixel 
+                     unsigned int series_skip; 
+                     const void *bla;                       // BlaTable<T> for the tier, or NULL 
+                     GlitchMode glitch; 
+                     bool reject_bulbs;                     // test pixels with in_main_bulbs first 
+                     unsigned int rejected;                 // pixels it found this frame 
+                     long period_exp;                       // cycle check tolerance 2^period_exp, 0 if off 
+                     unsigned int *counts;                  // every pixel's count, when subdividing, else NULL 
+                     unsigned int filled;                   // pixels subdivision filled this frame 
+                     std::vector<unsigned int> glitched;    // pixels to redo under GLITCH_REFERENCES, Dy*xsize + Dx 
+                     unsigned int rebased;                  // pixels GLITCH_REBASE carried on with this frame 
+                     const unsigned int *redo;              // glitched pixels to do again ... 
+                     unsigned int redo_count; 
+                     unsigned int ref_x, ref_y;             // ... against the orbit of this pixel 
+                     TileScheduler *scheduler; 
+                     unsigned char *bytearray; }; // caller's frame (xsize x ysize x 3)
 typedef struct worker_args worker_args;
 
-// GLOBAL DATA
-unsigned char** glb_bytearray; // this will contain an array of bytearrays
-                               // ncpus x (num points in array)  
-
 
 // ----------------------------------------------------------------------------
 // short utility function to assign the rgb values to the Color struct
@@ -183,51 +221,293 @@ static struct Color Ultra_Fractal_colors(const int it, const int maxiter)
     }
 }
 
-/* ----------------------------------------------------------------------------
- * calculate_point
- * run the z = z^2 + c algorithm for the point provided to assertain if the
- * point is inside or outside of the mandelbrot set
- *
- * Params
- * x0, y0 (double) location to calculate for
- * maxiter (int) the escape value
- *
- * Returns
- * iteration - count of how many iterations it took to head to infinity
- */
-/*static int calculate_point(double x0, double y0, int maxiter)
-{
-    double x = 0.0;
-    double y = 0.0;
-    double xsq = 0.0;
-    double ysq = 0.0;
-    int iteration = 0;
-    double xtemp = 0.0;
-
-    while (((xsq + ysq) <= 2*2) && iteration < maxiter)
-    {
-        xsq = x*x;
-        ysq = y*y;
-        xtemp = xsq - ysq + x0;
-        y = 2.0*x*y + y0;
-        x = xtemp;
-        iteration++;
-    }
-    return iteration;
-}*/
-
 // ----------------------------------------------------------------------------
 // setup_c - create the corner variables ar mpfr types
 //
 void MandelbrotMpfr::initialise_mpfr_vars()
 {
     // create all mpfr_t vars 
-    mpfr_inits2(PRECISION, Xs, Xe, Ys, Ye, Cx, Cy, (mpfr_ptr)NULL);
-    mpfr_inits2(PRECISION, MX, MY, Xe_Xs, Ye_Ys, (mpfr_ptr)NULL);
-    mpfr_inits2(PRECISION, CX, CY, (mpfr_ptr)NULL);
+    mpfr_inits2(m_viewPrecision, Xs, Xe, Ys, Ye, Cx, Cy, (mpfr_ptr)NULL);
+    mpfr_inits2(m_viewPrecision, MX, MY, Xe_Xs, Ye_Ys, (mpfr_ptr)NULL);
+    mpfr_inits2(m_viewPrecision, CX, CY, (mpfr_ptr)NULL);
     TRACE_DEBUG("called setup_c()\n");
 }
 
+// ----------------------------------------------------------------------------
+// update_precision - work out how many bits this view needs
+//
+// neighbouring pixels differ by dx = (Xe-Xs)/xsize, so to tell them apart the
+// coordinates need the bits between the top of the largest corner and the
+// bottom of dx, plus PRECISION_GUARD_BITS for the error the iteration builds
+// up.  rounded up to whole limbs so a zoom sequence only re-inits the workers
+// once every 64 or so halvings.  the view vars are kept a limb ahead of that
+// so zooming in never loses the bits the next frame will need.
+//
+void MandelbrotMpfr::update_precision(const unsigned int xsize)
+{
+    mpfr_sub(Xe_Xs, Xe, Xs, MPFR_RNDN);
+    mpfr_sub(Ye_Ys, Ye, Ys, MPFR_RNDN);
+    if (mpfr_zero_p(Xe_Xs) || mpfr_zero_p(Ye_Ys)) {
+        return; // degenerate view, leave the precision alone
+    }
+
+    mpfr_exp_t top = 1;
+    mpfr_srcptr corners[4] = { Xs, Xe, Ys, Ye };
+    for (mpfr_srcptr corner : corners)
+    {
+        if (!mpfr_zero_p(corner) && (mpfr_get_exp(corner) > top)) {
+            top = mpfr_get_exp(corner);
+        }
+    }
+    mpfr_exp_t span = (mpfr_get_exp(Xe_Xs) < mpfr_get_exp(Ye_Ys)) ? mpfr_get_exp(Xe_Xs) : mpfr_get_exp(Ye_Ys);
+    mpfr_exp_t bottom = span - (mpfr_exp_t)ceil(log2((double)(xsize > 1 ? xsize : 1)));
+
+    m_pixelBits = (int)(top - bottom);
+    m_pixelExp = (int)bottom;
+
+    long bits = (long)m_pixelBits + PRECISION_GUARD_BITS;
+    bits = ((bits + mp_bits_per_limb - 1) / mp_bits_per_limb) * mp_bits_per_limb;
+    if (bits < PRECISION) {
+        bits = PRECISION;
+    }
+    if (bits != m_framePrecision) {
+        TRACE_DEBUGV("frame precision %d -> %ld bits\n", m_framePrecision, bits);
+        m_framePrecision = (int)bits;
+    }
+    grow_view_precision(m_framePrecision + mp_bits_per_limb);
+}
+
+// ----------------------------------------------------------------------------
+// select_tier - the cheapest numeric type whose mantissa holds the bits that
+// resolve a pixel with TIER_GUARD_BITS to spare.  long double only counts
+// where it is wider than double (x87 80 bit), then double-double and
+// quad-double (or fixed point), then mpfr.  a fixed point frame the kernels
+// can't do runs in mpfr.  perturbation takes over straight after long double
+//
+NumericTier MandelbrotMpfr::select_tier()
+{
+    if ((m_tier == TIER_FIXED_POINT) && !fixed_point_usable()) {
+        return TIER_MPFR;
+    }
+    if (m_tier != TIER_AUTO) {
+        return m_tier;
+    }
+    int bits = m_pixelBits + TIER_GUARD_BITS;
+    if (bits <= FLT_MANT_DIG) {
+        return TIER_FLOAT;
+    }
+    if (bits <= DBL_MANT_DIG) {
+        return TIER_DOUBLE;
+    }
+    if ((LDBL_MANT_DIG > DBL_MANT_DIG) && (bits <= LDBL_MANT_DIG)) {
+        return TIER_LONG_DOUBLE;
+    }
+    if (!m_usePerturbation) {
+        // where it's on, fixed point beats quad-double at every width, and
+        // double-double too once it runs across vector lanes
+        bool fixed = m_useFixedPoint && fixed_point_usable();
+        if ((bits <= DDOUBLE_MANT_DIG) && !(fixed && (m_simdLevel != SIMD_SCALAR))) {
+            return TIER_DOUBLE_DOUBLE;
+        }
+        if (fixed) {
+            return TIER_FIXED_POINT;
+        }
+        if (bits <= QDOUBLE_MANT_DIG) {
+            return TIER_QUAD_DOUBLE;
+        }
+        return TIER_MPFR;
+    }
+    // the offsets have to keep their low bits clear of the double underflow
+    if (m_pixelExp - TIER_GUARD_BITS < DBL_MIN_EXP) {
+        return TIER_PERTURBATION_FLOATEXP;
+    }
+    return TIER_PERTURBATION;
+}
+
+// ----------------------------------------------------------------------------
+// fixed_point_usable - there is a kernel for the frame's precision and the view
+// keeps z inside the integer bits
+//
+bool MandelbrotMpfr::fixed_point_usable()
+{
+    return (fixed_limbs(m_framePrecision) <= FIXED_MAX_LIMBS) && fixed_point_fits(Xs, Xe, Ys, Ye);
+}
+
+// ----------------------------------------------------------------------------
+// compute_reference - the reference orbit for a perturbation frame, left in
+// CX, CY.  MX, MY (the point being zoomed into) when it is in view, as it is
+// the point most likely to stay in the set, else the centre of the view.
+//
+// zooming into a fixed point every frame has the same reference, so the orbit
+// of the last frame is kept while it has the bits this one needs, and only
+// iterated further if maxiter has gone up.  once it runs out of bits the new
+// one gets m_referencePrecision, or twice the old precision if there's no
+// plan, so an open ended zoom recomputes it a handful of times at most.
+//
+// with an orbit cache a new orbit is looked for on disk before it is computed,
+// and every orbit with new points is written back.
+//
+void MandelbrotMpfr::compute_reference()
+{
+    if ((mpfr_cmp(MX, Xs) >= 0) && (mpfr_cmp(MX, Xe) <= 0) && 
+        (mpfr_cmp(MY, Ys) >= 0) && (mpfr_cmp(MY, Ye) <= 0)) {
+        mpfr_set(CX, MX, MPFR_RNDN);
+        mpfr_set(CY, MY, MPFR_RNDN);
+    } else {
+        mpfr_add(CX, Xs, Xe, MPFR_RNDN);
+        mpfr_div_2ui(CX, CX, 1, MPFR_RNDN);
+        mpfr_add(CY, Ys, Ye, MPFR_RNDN);
+        mpfr_div_2ui(CY, CY, 1, MPFR_RNDN);
+    }
+    m_orbit->setCompressed(compress_orbits());
+    m_orbitReused = m_reuseOrbit && m_orbit->matches(CX, CY, m_framePrecision);
+    if (m_orbitReused) {
+        m_orbit->extend(m_maxIter);
+    } else {
+        int bits = (m_referencePrecision > m_framePrecision) ? m_referencePrecision : m_framePrecision;
+        if (m_reuseOrbit && m_orbit->sameCentre(CX, CY) && (bits < 2 * m_orbit->precision())) {
+            bits = 2 * m_orbit->precision();
+        }
+        m_orbitCached = (m_orbitCache != NULL) && m_orbitCache->load(m_orbit, CX, CY, bits);
+        if (m_orbitCached) {
+            m_orbitStored = m_orbit->generation();
+            m_orbit->extend(m_maxIter);
+        } else {
+            m_orbit->compute(CX, CY, bits, m_maxIter);
+        }
+    }
+    // write it back whenever it has new points, computed or extended
+    if ((m_orbitCache != NULL) && (m_orbitStored != m_orbit->generation())) {
+        m_orbitCache->store(m_orbit);
+        m_orbitStored = m_orbit->generation();
+    }
+    TRACE_DEBUGV("reference orbit %u points at %d bits%s%s\n", m_orbit->length(), m_orbit->precision(), 
+                 m_orbitReused ? " (reused)" : "", m_orbitCached ? " (cached)" : "");
+}
+
+// ----------------------------------------------------------------------------
+// compress_orbits - true if reference orbits should be kept as waypoints
+//
+bool MandelbrotMpfr::compress_orbits()
+{
+    return (m_orbitStorage == ORBIT_STORAGE_COMPRESSED) ||
+           ((m_orbitStorage == ORBIT_STORAGE_AUTO) && (m_maxIter >= ORBIT_COMPRESS_MAXITER));
+}
+
+// ----------------------------------------------------------------------------
+// setOrbitCache - keep reference orbits in files under directory, at most
+// capacity bytes of them.  an empty directory stops using the cache.
+//
+void MandelbrotMpfr::setOrbitCache(const std::string &directory, const size_t capacity)
+{
+    delete m_orbitCache;
+    m_orbitCache = directory.empty() ? NULL : new OrbitCache(directory, capacity);
+    m_orbitStored = m_orbit->generation();
+}
+
+// ----------------------------------------------------------------------------
+// planZoomSequence - set the reference precision to what the frame after
+// zooms more zoom_in steps will need, each step scales the view by
+// m_zoom_factor percent
+//
+void MandelbrotMpfr::planZoomSequence(const unsigned int zooms, const unsigned int xsize)
+{
+    update_precision(xsize);
+    double step = ((m_zoom_factor > 0) && (m_zoom_factor < 100)) ? log2(100.0 / (double)m_zoom_factor) : 0.0;
+    long bits = (long)m_pixelBits + (long)ceil(step * zooms) + PRECISION_GUARD_BITS;
+    bits = ((bits + mp_bits_per_limb - 1) / mp_bits_per_limb) * mp_bits_per_limb;
+    m_referencePrecision = (bits > m_framePrecision) ? (int)bits : m_framePrecision;
+    TRACE_DEBUGV("%u zooms, reference orbits at %d bits\n", zooms, m_referencePrecision);
+}
+
+// ----------------------------------------------------------------------------
+const char* MandelbrotMpfr::tierName(const NumericTier tier)
+{
+    switch (tier)
+    {
+        case TIER_AUTO:                  return "auto";
+        case TIER_FLOAT:                 return "float";
+        case TIER_DOUBLE:                return "double";
+        case TIER_LONG_DOUBLE:           return "long double";
+        case TIER_DOUBLE_DOUBLE:         return "double-double";
+        case TIER_QUAD_DOUBLE:           return "quad-double";
+        case TIER_FIXED_POINT:           return "fixed point";
+        case TIER_MPFR:                  return "mpfr";
+        case TIER_PERTURBATION:          return "perturbation";
+        case TIER_PERTURBATION_FLOATEXP: return "perturbation floatexp";
+    }
+    return "unknown";
+}
+
+// ----------------------------------------------------------------------------
+// grow_view_precision - round the corner/centre vars up to at least bits,
+// keeping their values
+//
+void MandelbrotMpfr::grow_view_precision(const int bits)
+{
+    if (bits <= m_viewPrecision) {
+        return;
+    }
+    m_viewPrecision = ((bits + mp_bits_per_limb - 1) / mp_bits_per_limb) * mp_bits_per_limb;
+
+    mpfr_ptr view[] = { Xs, Xe, Ys, Ye, Cx, Cy, MX, MY, Xe_Xs, Ye_Ys, CX, CY };
+    for (mpfr_ptr v : view)
+    {
+        mpfr_prec_round(v, m_viewPrecision, MPFR_RNDN);
+    }
+    TRACE_DEBUGV("view precision %d bits\n", m_viewPrecision);
+}
+
+// ----------------------------------------------------------------------------
+// prepare_worker_state - make sure there is one worker_args per worker with
+// all of its mpfr_t vars initialised at m_framePrecision.  Nothing is allocated
+// unless ncpus or the frame precision changed since the last frame.
+//
+void MandelbrotMpfr::prepare_worker_state()
+{
+    if ((m_wargs != NULL) && (m_wargsCount == ncpus) && (m_wargsPrecision == m_framePrecision)) {
+        return;
+    }
+    free_worker_state();
+
+    m_wargs = new worker_args[ncpus];
+    for(int tid=0; tid<ncpus; tid++)
+    {
+        worker_args *cp = &(m_wargs[tid]);
+        mpfr_inits2(m_framePrecision, cp->Xe, cp->Xs, cp->Ye, cp->Ys, cp->dx, cp->dy, (mpfr_ptr)NULL);
+        mpfr_inits2(m_framePrecision, cp->x, cp->y, cp->xsq, cp->ysq, cp->x0r, cp->y0i, (mpfr_ptr)NULL);
+        mpfr_inits2(m_framePrecision, cp->a, cp->sum_xsq_ysq, cp->xs, cp->ys, (mpfr_ptr)NULL);
+        fixed_scratch_init(&(cp->fixed_scratch), m_framePrecision);
+        cp->arena = m_useArena ? new MpfrArena(MPFR_ARENA_SIZE) : NULL;
+    }
+    m_wargsCount = ncpus;
+    m_wargsPrecision = m_framePrecision;
+    TRACE_DEBUGV("worker state for %d workers at %d bits\n", ncpus, m_framePrecision);
+}
+
+// ----------------------------------------------------------------------------
+// free_worker_state - release everything prepare_worker_state created
+//
+void MandelbrotMpfr::free_worker_state()
+{
+    if (m_wargs == NULL) {
+        return;
+    }
+    for(int tid=0; tid<m_wargsCount; tid++)
+    {
+        worker_args *cp = &(m_wargs[tid]);
+        mpfr_clears(cp->Xe, cp->Xs, cp->Ye, cp->Ys, cp->dx, cp->dy, (mpfr_ptr)NULL);
+        mpfr_clears(cp->x, cp->y, cp->xsq, cp->ysq, cp->x0r, cp->y0i, (mpfr_ptr)NULL);
+        mpfr_clears(cp->a, cp->sum_xsq_ysq, cp->xs, cp->ys, (mpfr_ptr)NULL);
+        fixed_scratch_clear(&(cp->fixed_scratch));
+        delete cp->arena;
+    }
+    delete [] m_wargs;
+    m_wargs = NULL;
+    m_wargsCount = 0;
+    m_wargsPrecision = 0;
+}
+
 // ----------------------------------------------------------------------------
 // multi-platform function to determine the number of cores available
 //
@@ -258,6 +538,7 @@ int MandelbrotMpfr::cpuCount()
     ncpus = sysconf(_SC_NPROCESSORS_ONLN);
 #endif
     std::cout << "ncpus = " << ncpus << "\n";
+    std::cout << "simd = " << simd_level_name(m_simdLevel) << "\n";
     return ncpus;
 }
 
@@ -274,6 +555,11 @@ void MandelbrotMpfr::initialize_c(
                )
 {
     TRACE_DEBUGV("called init_c(Cx = %s \nCy = %s )\n", Cx_str, Cy_str);
+
+    // make room for every digit of a long centre point (log2(10) bits per digit)
+    size_t digits = (strlen(Cx_str) > strlen(Cy_str)) ? strlen(Cx_str) : strlen(Cy_str);
+    grow_view_precision((int)ceil(digits * log2(10.0)) + PRECISION_GUARD_BITS);
+
     mpfr_set_str(Xs, Xs_str, 10, MPFR_RNDN);
     mpfr_set_str(Xe, Xe_str, 10, MPFR_RNDN);
     mpfr_set_str(Ys, Ys_str, 10, MPFR_RNDN);
@@ -368,6 +654,9 @@ void MandelbrotMpfr::zoom_in_via_mouse(
 void MandelbrotMpfr::zoom_in(const unsigned int screen_width, const unsigned int screen_height)
 {
     //printf("mpfr_zoom_in()\n");
+
+    // keep the view vars a limb ahead of what the new corners will need
+    update_precision(screen_width);
   
     //printf("MX, MY ");
     //mpfr_out_str(stdout, 10, 10, MX, MPFR_RNDN); std::cout << ", ";
@@ -528,120 +817,947 @@ void MandelbrotMpfr::zoom_out( )
     }
 }
 
+// ----------------------------------------------------------------------------
+// get_long_double - v as a long double, built from two doubles because
+// mpfr_get_ld allocates a temporary on every call.  scratch must have v's
+// precision.
+//
+static long double get_long_double(mpfr_srcptr v, mpfr_ptr scratch)
+{
+    double hi = mpfr_get_d(v, MPFR_RNDN);
+    mpfr_sub_d(scratch, v, hi, MPFR_RNDN);
+    return (long double)hi + (long double)mpfr_get_d(scratch, MPFR_RNDN);
+}
+
+// ----------------------------------------------------------------------------
+// get_qdouble - v to 212 bits, each double the rounded remainder of the ones
+// before.  scratch must have v's precision
+//
+static qdouble get_qdouble(mpfr_srcptr v, mpfr_ptr scratch)
+{
+    double parts[4];
+    mpfr_set(scratch, v, MPFR_RNDN);
+    for (int i = 0; i < 4; i++)
+    {
+        parts[i] = mpfr_get_d(scratch, MPFR_RNDN);
+        mpfr_sub_d(scratch, scratch, parts[i], MPFR_RNDN);
+    }
+    return qdouble(parts[0], parts[1], parts[2], parts[3]);
+}
+
+// ----------------------------------------------------------------------------
+// get_floatexp - v as a floatexp, whatever its exponent
+//
+static floatexp get_floatexp(mpfr_srcptr v)
+{
+    long exp = 0;
+    double mant = mpfr_get_d_2exp(&exp, v, MPFR_RNDN);
+    return floatexp(mant, (int64_t)exp);
+}
+
+// ----------------------------------------------------------------------------
+// pixel_in_bulbs - pixel (Dx, Dy) of the frame is inside the main cardioid or the
+// period 2 bulb, counted in cp->rejected.  every tier tests it in double from the
+// long double corner, whatever it iterates in, so they all reject the same pixels.
+// y is the row's from row_bulbs_y
+//
+static inline double row_bulbs_y(const worker_args *cp, const unsigned int Dy)
+{
+    return (double)(cp->Ys_ld + (long double)Dy * cp->dy_ld);
+}
+
+static inline bool pixel_in_bulbs(worker_args *cp, const unsigned int Dx, const double y)
+{
+    if (!cp->reject_bulbs || !in_main_bulbs((double)(cp->Xs_ld + (long double)Dx * cp->dx_ld), y)) {
+        return false;
+    }
+    cp->rejected++;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// store_count - keep pixel (Dx, Dy)'s iteration count for the subdivision to
+// compare, when there is one
+//
+static inline void store_count(worker_args *cp, const unsigned int Dx, const unsigned int Dy, const unsigned int iteration)
+{
+    if (cp->counts != NULL) {
+        cp->counts[(size_t)Dy * cp->xsize + Dx] = iteration;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// escape_runs - a row (or column) kernel over count pixels, run only on the
+// stretches between the pixels in_main_bulbs rejects, which get maxiter.
+// inside(i) tests pixel i of them, run(first, n, iterations) does n pixels from
+// pixel first
+//
+template<typename Inside, typename Run>
+static void escape_runs(worker_args *cp, const unsigned int count, unsigned int *iterations, Inside inside, Run run)
+{
+    unsigned int first = 0;
+    for (unsigned int i = 0; i <= count; i++)
+    {
+        if ((i < count) && !inside(i)) {
+            continue;
+        }
+        if (i > first) {
+            run(first, i - first, iterations + first);
+        }
+        if (i < count) {
+            iterations[i] = cp->maxiter;
+        }
+        first = i + 1;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// frame values for process_slice_typed.  the hardware types take the corner and
+// spacing from long double and step the rows in it, the multi-double types take
+// them from the quad-double expansions and step in their own arithmetic
+//
+template<typename T>
+static inline T frame_value(const long double ld, const qdouble &)
+{
+    return (T)ld;
+}
+
+template<>
+inline ddouble frame_value<ddouble>(const long double, const qdouble &qd)
+{
+    return ddouble(qd[0], qd[1]);
+}
+
+template<>
+inline qdouble frame_value<qdouble>(const long double, const qdouble &qd)
+{
+    return qd;
+}
+
+template<typename T>
+static inline T row_y0(const worker_args *cp, const unsigned int Dy)
+{
+    return (T)(cp->Ys_ld + (long double)Dy * cp->dy_ld);
+}
+
+template<>
+inline ddouble row_y0<ddouble>(const worker_args *cp, const unsigned int Dy)
+{
+    return frame_value<ddouble>(0, cp->Ys_qd) + ddouble((double)Dy) * frame_value<ddouble>(0, cp->dy_qd);
+}
+
+template<>
+inline qdouble row_y0<qdouble>(const worker_args *cp, const unsigned int Dy)
+{
+    return cp->Ys_qd + qdouble((double)Dy) * cp->dy_qd;
+}
+
+// ----------------------------------------------------------------------------
+// process_slice_typed - worker_process_slice for the hardware and multi-double
+// tiers, the same tile walk but calculate_point<T> in place of the mpfr loop
+//
+template<typename T>
+static void process_slice_typed(worker_args *cp)
+{
+    const T Xs = frame_value<T>(cp->Xs_ld, cp->Xs_qd);
+    const T dx = frame_value<T>(cp->dx_ld, cp->dx_qd);
+    const T eps = (cp->period_exp != 0) ? T(ldexp(1.0, (int)cp->period_exp)) : T(0);
+    unsigned int iteration = 0;
+    size_t bc = 0; // bytearray index counter 
+    Color rgb;
+
+    for (unsigned int Dy = cp->y0; Dy < cp->y1; Dy++)
+    {
+        bc = ((size_t)Dy * cp->xsize + cp->x0) * 3;
+        const T y0 = row_y0<T>(cp, Dy);
+        const double yb = row_bulbs_y(cp, Dy);
+
+        for (unsigned int Dx = cp->x0; Dx < cp->x1; Dx++)
+        {
+            if (pixel_in_bulbs(cp, Dx, yb)) {
+                iteration = cp->maxiter;
+            } else {
+                iteration = calculate_point<T>(Xs + (T)(double)Dx * dx, y0, cp->maxiter, eps);
+            }
+            store_count(cp, Dx, Dy, iteration);
+
+            rgb = Ultra_Fractal_colors(iteration, cp->maxiter);
+            cp->bytearray[bc++] = rgb.r;
+            cp->bytearray[bc++] = rgb.g;
+            cp->bytearray[bc++] = rgb.b;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// process_slice_perturbation - the perturbation tiers, each pixel iterates its
+// offset dc from the reference point against the reference orbit.  T is double
+// or floatexp, Orbit the cursor that reads the orbit as it is stored
+//
+template<typename T, typename Orbit>
+static void process_slice_perturbation_with(worker_args *cp)
+{
+    Orbit orbit(cp->orbit);
+    const T dx = (T)cp->dx_fe;
+    const T dy = (T)cp->dy_fe;
+    unsigned int iteration = 0;
+    size_t bc = 0; // bytearray index counter 
+    Color rgb;
+    floatexp d0x, d0y;
+
+    for (unsigned int Dy = cp->y0; Dy < cp->y1; Dy++)
+    {
+        bc = ((size_t)Dy * cp->xsize + cp->x0) * 3;
+        const T dcy = (T)cp->dcy0 + T((double)Dy) * dy;
+        const floatexp dcy_fe = cp->dcy0 + floatexp((double)Dy) * cp->dy_fe;
+        const double yb = row_bulbs_y(cp, Dy);
+
+        for (unsigned int Dx = cp->x0; Dx < cp->x1; Dx++)
+        {
+            if (pixel_in_bulbs(cp, Dx, yb)) {
+                store_count(cp, Dx, Dy, cp->maxiter);
+                rgb = Ultra_Fractal_colors(cp->maxiter, cp->maxiter);
+                cp->bytearray[bc++] = rgb.r;
+                cp->bytearray[bc++] = rgb.g;
+                cp->bytearray[bc++] = rgb.b;
+                continue;
+            }
+            const T dcx = (T)cp->dcx0 + T((double)Dx) * dx;
+            if (cp->series_skip > 0) {
+                cp->series->evaluate(cp->dcx0 + floatexp((double)Dx) * cp->dx_fe, dcy_fe, &d0x, &d0y);
+            }
+            bool glitched = false;
+            iteration = calculate_point_perturbed<T>(orbit, dcx, dcy, cp->maxiter, 
+                                                     cp->series_skip, (T)d0x, (T)d0y, 
+                                                     (const BlaTable<T>*)cp->bla, cp->glitch, &glitched);
+            // a rebased pixel's count is final, only one stopped early waits for another reference
+            if (glitched && (cp->glitch == GLITCH_REFERENCES)) {
+                cp->glitched.push_back(Dy * cp->xsize + Dx);
+                store_count(cp, Dx, Dy, COUNT_GLITCHED);
+            } else {
+                cp->rebased += glitched;
+                store_count(cp, Dx, Dy, iteration);
+            }
+
+            rgb = Ultra_Fractal_colors(iteration, cp->maxiter);
+            cp->bytearray[bc++] = rgb.r;
+            cp->bytearray[bc++] = rgb.g;
+            cp->bytearray[bc++] = rgb.b;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// process_glitches - the worker's share of the redo list, each pixel again from
+// the start against the orbit of pixel (ref_x, ref_y).  its offset from that
+// pixel is a whole number of pixel spacings, so dc comes without any mpfr.
+// those still glitched go back on the worker's list.
+//
+template<typename T, typename Orbit>
+static void process_glitches_with(worker_args *cp)
+{
+    Orbit orbit(cp->orbit);
+    const T dx = (T)cp->dx_fe;
+    const T dy = (T)cp->dy_fe;
+    const unsigned int first = (unsigned int)(((unsigned long long)cp->tid * cp->redo_count) / cp->cpus);
+    const unsigned int last = (unsigned int)(((unsigned long long)(cp->tid + 1) * cp->redo_count) / cp->cpus);
+    unsigned int iteration = 0;
+    Color rgb;
+
+    for (unsigned int i = first; i < last; i++)
+    {
+        const unsigned int pixel = cp->redo[i];
+        const unsigned int Dx = pixel % cp->xsize;
+        const unsigned int Dy = pixel / cp->xsize;
+        const T dcx = T((double)Dx - (double)cp->ref_x) * dx;
+        const T dcy = T((double)Dy - (double)cp->ref_y) * dy;
+
+        bool glitched = false;
+        iteration = calculate_point_perturbed<T>(orbit, dcx, dcy, cp->maxiter, 0, T(0), T(0), 
+                                                 NULL, GLITCH_REFERENCES, &glitched);
+        if (glitched) {
+            cp->glitched.push_back(pixel);
+        }
+
+        size_t bc = (size_t)pixel * 3;
+        rgb = Ultra_Fractal_colors(iteration, cp->maxiter);
+        cp->bytearray[bc++] = rgb.r;
+        cp->bytearray[bc++] = rgb.g;
+        cp->bytearray[bc++] = rgb.b;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// the cursor for a full or a compressed reference orbit
+//
+template<typename T>
+static void process_slice_perturbation(worker_args *cp)
+{
+    if (cp->orbit->compressed()) {
+        process_slice_perturbation_with<T, OrbitWaypointCursor>(cp);
+    } else {
+        process_slice_perturbation_with<T, OrbitArrayCursor>(cp);
+    }
+}
+
+template<typename T>
+static void process_glitches(worker_args *cp)
+{
+    if (cp->orbit->compressed()) {
+        process_glitches_with<T, OrbitWaypointCursor>(cp);
+    } else {
+        process_glitches_with<T, OrbitArrayCursor>(cp);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// process_column_double - a slice one pixel wide, from subdivision, down the
+// escape_column kernel so it keeps the vector lanes full.  every pixel gets the
+// x and y a row would have given it
+//
+static void process_column_double(worker_args *cp)
+{
+    const unsigned int Dx = cp->x0;
+    const double x0 = (double)cp->Xs_ld + (double)Dx * (double)cp->dx_ld;
+    const double eps = (cp->period_exp != 0) ? ldexp(1.0, (int)cp->period_exp) : 0.0;
+    double y0[TILE_SIZE];
+    unsigned int iterations[TILE_SIZE];
+    Color rgb;
+
+    for (unsigned int Dy = cp->y0; Dy < cp->y1; Dy += TILE_SIZE)
+    {
+        unsigned int count = (cp->y1 - Dy < TILE_SIZE) ? cp->y1 - Dy : TILE_SIZE;
+        for (unsigned int i = 0; i < count; i++)
+        {
+            y0[i] = (double)(cp->Ys_ld + (long double)(Dy + i) * cp->dy_ld);
+        }
+        escape_runs(cp, count, iterations, [&](unsigned int i) { return pixel_in_bulbs(cp, Dx, y0[i]); },
+                    [&](unsigned int first, unsigned int n, unsigned int *it) {
+                        cp->escape_column(x0, y0 + first, n, cp->maxiter, eps, it);
+                    });
+
+        for (unsigned int i = 0; i < count; i++)
+        {
+            size_t bc = ((size_t)(Dy + i) * cp->xsize + Dx) * 3;
+            store_count(cp, Dx, Dy + i, iterations[i]);
+            rgb = Ultra_Fractal_colors(iterations[i], cp->maxiter);
+            cp->bytearray[bc++] = rgb.r;
+            cp->bytearray[bc++] = rgb.g;
+            cp->bytearray[bc++] = rgb.b;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// process_slice_double - the double tier, each row of the tile goes through the
+// escape_row kernel (several pixels per instruction where the cpu can) and is
+// coloured from the iteration counts afterwards
+//
+static void process_slice_double(worker_args *cp)
+{
+    const double Xs = (double)cp->Xs_ld;
+    const double dx = (double)cp->dx_ld;
+    const double eps = (cp->period_exp != 0) ? ldexp(1.0, (int)cp->period_exp) : 0.0;
+    unsigned int iterations[TILE_SIZE];
+    size_t bc = 0; // bytearray index counter 
+    Color rgb;
+
+    if ((cp->x1 - cp->x0 == 1) && (cp->y1 - cp->y0 > 1)) {
+        process_column_double(cp);
+        return;
+    }
+
+    for (unsigned int Dy = cp->y0; Dy < cp->y1; Dy++)
+    {
+        bc = ((size_t)Dy * cp->xsize + cp->x0) * 3;
+        const double y0 = (double)(cp->Ys_ld + (long double)Dy * cp->dy_ld);
+
+        for (unsigned int Dx = cp->x0; Dx < cp->x1; Dx += TILE_SIZE)
+        {
+            unsigned int count = (cp->x1 - Dx < TILE_SIZE) ? cp->x1 - Dx : TILE_SIZE;
+            escape_runs(cp, count, iterations, [&](unsigned int i) { return pixel_in_bulbs(cp, Dx + i, y0); },
+                        [&](unsigned int first, unsigned int n, unsigned int *it) {
+                            cp->escape_row(Xs, dx, Dx + first, n, y0, cp->maxiter, eps, it);
+                        });
+
+            for (unsigned int i = 0; i < count; i++)
+            {
+                store_count(cp, Dx + i, Dy, iterations[i]);
+                rgb = Ultra_Fractal_colors(iterations[i], cp->maxiter);
+                cp->bytearray[bc++] = rgb.r;
+                cp->bytearray[bc++] = rgb.g;
+                cp->bytearray[bc++] = rgb.b;
+            }
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// process_column_fixed - process_column_double for the fixed point tier, the
+// column's x is worked out in mpfr as a row's first pixel is
+//
+static void process_column_fixed(worker_args *cp)
+{
+    const unsigned int Dx = cp->x0;
+    unsigned int iterations[TILE_SIZE];
+    Color rgb;
+
+    mpfr_mul_ui(cp->x0r, cp->dx, Dx, MPFR_RNDN);
+    mpfr_add(cp->x0r, cp->x0r, cp->Xs, MPFR_RNDN);
+    for (unsigned int Dy = cp->y0; Dy < cp->y1; Dy += TILE_SIZE)
+    {
+        unsigned int count = (cp->y1 - Dy < TILE_SIZE) ? cp->y1 - Dy : TILE_SIZE;
+        escape_runs(cp, count, iterations, [&](unsigned int i) { return pixel_in_bulbs(cp, Dx, row_bulbs_y(cp, Dy + i)); },
+                    [&](unsigned int first, unsigned int n, unsigned int *it) {
+                        cp->fixed_column(cp->x0r, cp->Ys, cp->dy, Dy + first, n, cp->maxiter, cp->period_exp, it,
+                                         &(cp->fixed_scratch));
+                    });
+
+        for (unsigned int i = 0; i < count; i++)
+        {
+            size_t bc = ((size_t)(Dy + i) * cp->xsize + Dx) * 3;
+            store_count(cp, Dx, Dy + i, iterations[i]);
+            rgb = Ultra_Fractal_colors(iterations[i], cp->maxiter);
+            cp->bytearray[bc++] = rgb.r;
+            cp->bytearray[bc++] = rgb.g;
+            cp->bytearray[bc++] = rgb.b;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// process_slice_fixed - the fixed point tier, the rows are started in mpfr as the
+// mpfr loop below does them and the fixed_row kernel does the pixels
+//
+static void process_slice_fixed(worker_args *cp)
+{
+    unsigned int iterations[TILE_SIZE];
+    size_t bc = 0; // bytearray index counter 
+    Color rgb;
+
+    if ((cp->x1 - cp->x0 == 1) && (cp->y1 - cp->y0 > 1)) {
+        process_column_fixed(cp);
+        return;
+    }
+
+    for (unsigned int Dy = cp->y0; Dy < cp->y1; Dy++)
+    {
+        bc = ((size_t)Dy * cp->xsize + cp->x0) * 3;
+        mpfr_mul_ui(cp->y0i, cp->dy, Dy, MPFR_RNDN);
+        mpfr_add(cp->y0i, cp->y0i, cp->Ys, MPFR_RNDN);
+        const double yb = row_bulbs_y(cp, Dy);
+
+        for (unsigned int Dx = cp->x0; Dx < cp->x1; Dx += TILE_SIZE)
+        {
+            unsigned int count = (cp->x1 - Dx < TILE_SIZE) ? cp->x1 - Dx : TILE_SIZE;
+            escape_runs(cp, count, iterations, [&](unsigned int i) { return pixel_in_bulbs(cp, Dx + i, yb); },
+                        [&](unsigned int first, unsigned int n, unsigned int *it) {
+                            cp->fixed_row(cp->Xs, cp->dx, Dx + first, n, cp->y0i, cp->maxiter, cp->period_exp, it,
+                                          &(cp->fixed_scratch));
+                        });
+
+            for (unsigned int i = 0; i < count; i++)
+            {
+                store_count(cp, Dx + i, Dy, iterations[i]);
+                rgb = Ultra_Fractal_colors(iterations[i], cp->maxiter);
+                cp->bytearray[bc++] = rgb.r;
+                cp->bytearray[bc++] = rgb.g;
+                cp->bytearray[bc++] = rgb.b;
+            }
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// mpfr_inside - sum <= 4 for a sum of squares.  sum = m*2^e with m in [0.5, 1),
+// so e <= 2 is under 4 and e > 3 is 8 or more, only [4, 8) needs the compare
+//
+static inline bool mpfr_inside(mpfr_srcptr sum)
+{
+    if (mpfr_zero_p(sum)) {
+        return true;
+    }
+    mpfr_exp_t e = mpfr_get_exp(sum);
+    if (e != 3) {
+        return (e < 3);
+    }
+    return (mpfr_cmp_ui(sum, 4) <= 0);
+}
+
+// ----------------------------------------------------------------------------
+// mpfr_near - |a - b| < 2^e, d is scratch.  |d| < 2^exponent(d) so the exponent
+// is the whole test
+//
+static inline bool mpfr_near(mpfr_ptr d, mpfr_srcptr a, mpfr_srcptr b, const long e)
+{
+    mpfr_sub(d, a, b, MPFR_RNDN);
+    return mpfr_zero_p(d) || (mpfr_get_exp(d) <= e);
+}
+
+// ----------------------------------------------------------------------------
+// mpfr_escape - calculate_point on the worker's mpfr variables, every op in
+// place with no temporaries.  per iteration:
+//
+//   SQUARE_CROSS false:  2 sqr, 1 mul, 1 mul_2ui, 4 add/sub
+//   SQUARE_CROSS true:   3 sqr, 6 add/sub, 2*x*y = (x+y)^2 - (xsq + ysq)
+//
+// plus the bailout, an exponent read (see mpfr_inside).  mul_2ui only bumps the
+// exponent, so the first is two squares and a multiply; the second trades the
+// multiply for a square and two adds, which only pays once the precision is
+// wide enough for a square to cost much less than a multiply
+// (MPFR_SQUARE_CROSS_BITS).  the loop they replace was 3 mul, 1 mul_d and 4
+// add/sub, then a mpfr_cmp_d.  the cycle check adds 1 or 2 subs, and a set
+// at every power of two
+//
+template<bool SQUARE_CROSS>
+static unsigned int mpfr_escape(worker_args *cp, mpfr_srcptr x0, mpfr_srcptr y0, const unsigned int maxiter)
+{
+    mpfr_ptr x = cp->x, y = cp->y, xsq = cp->xsq, ysq = cp->ysq, sum = cp->sum_xsq_ysq;
+    mpfr_ptr xs = cp->xs, ys = cp->ys;
+    const long period_exp = cp->period_exp;
+    unsigned int save = 1;
+    unsigned int iteration = 0;
+
+    mpfr_set_zero(x, 1);
+    mpfr_set_zero(y, 1);
+    mpfr_set_zero(sum, 1);
+    mpfr_set_zero(xs, 1);
+    mpfr_set_zero(ys, 1);
+    while (mpfr_inside(sum) && (iteration < maxiter))
+    {
+        mpfr_sqr(xsq, x, MPFR_RNDN);             // xsq = x*x
+        mpfr_sqr(ysq, y, MPFR_RNDN);             // ysq = y*y
+        mpfr_add(sum, xsq, ysq, MPFR_RNDN);      // for the while test
+        if (SQUARE_CROSS) {
+            mpfr_add(y, y, x, MPFR_RNDN);        // y = (x+y)^2 - (xsq + ysq) + y0
+            mpfr_sqr(y, y, MPFR_RNDN);
+            mpfr_sub(y, y, sum, MPFR_RNDN);
+        } else {
+            mpfr_mul(y, y, x, MPFR_RNDN);        // y = 2*x*y + y0
+            mpfr_mul_2ui(y, y, 1, MPFR_RNDN);
+        }
+        mpfr_add(y, y, y0, MPFR_RNDN);
+        mpfr_sub(x, xsq, ysq, MPFR_RNDN);        // x = xsq - ysq + x0
+        mpfr_add(x, x, x0, MPFR_RNDN);
+        iteration++;
+
+        if (period_exp != 0) {
+            if (mpfr_near(cp->a, x, xs, period_exp) && mpfr_near(cp->a, y, ys, period_exp)) {
+                return maxiter;
+            }
+            if (iteration == save) {
+                mpfr_set(xs, x, MPFR_RNDN);
+                mpfr_set(ys, y, MPFR_RNDN);
+                save *= 2;
+            }
+        }
+    }
+    return iteration;
+}
+
 // ----------------------------------------------------------------------------
 // worker_process_slice (used in the threads)
 //
-// given a slice of the mandelbrot set data to process.
-// returns part of the result to be combined later.
+// given a slice (tile) of the mandelbrot set data to process, x0..x1 by y0..y1
+// in pixels of the whole xsize by ysize frame.
+// writes its part of the result straight into the caller's bytearray at the
+// tile's row offsets.
+//
+// the pixel spacing dx, dy is worked out once per frame, so each row starts
+// at y0 = Ys + Dy*dy, x0 = Xs + x0*dx and x0 then steps by one add of dx per
+// column rather than being rescaled through a double for every pixel.
 //
 void* MandelbrotMpfr::worker_process_slice(void* arg)
 {
     worker_args *cp;
     cp = (worker_args*)arg;
     unsigned int maxiter = cp->maxiter;
-    unsigned int precision = cp->precision;
     unsigned int iteration = 0;
-    unsigned int bc = 0; // bytearray index counter 
+    size_t bc = 0; // bytearray index counter 
     Color rgb;
 
-    mpfr_t x, y, xsq, ysq, xtmp, x0, y0; // algorithm values 
-    mpfr_t a, sum_xsq_ysq;               // tmp vals 
+    // the mpfr_t vars live in the worker's state, created once by prepare_worker_state 
+    mpfr_ptr x0 = cp->x0r, y0 = cp->y0i;
+    const bool square_cross = (cp->precision >= MPFR_SQUARE_CROSS_BITS);
     
     TRACE_DEBUGV("Start Thread[%d](%d,%d) (%d,%d)\n",cp->tid, cp->x0, cp->y0, cp->x1, cp->y1);
-    TRACE_DEBUGV("Start Thread %d\n",cp->tid);
 
-    // create all mpfr_t vars 
-    mpfr_inits2(precision, x, y, xsq, ysq, xtmp, x0, y0, (mpfr_ptr)NULL);
-    mpfr_inits2(precision, a, sum_xsq_ysq, (mpfr_ptr)NULL);
-
-    // initialise all mpfr_t vars 
-    mpfr_set_d(x, 0.0, MPFR_RNDN);
-    mpfr_set_d(y, 0.0, MPFR_RNDN);
-    mpfr_set_d(xsq, 0.0, MPFR_RNDN);
-    mpfr_set_d(ysq, 0.0, MPFR_RNDN);
-    mpfr_set_d(xtmp, 0.0, MPFR_RNDN);
-    mpfr_set_d(x0, 0.0, MPFR_RNDN);
-    mpfr_set_d(y0, 0.0, MPFR_RNDN);
-    mpfr_set_d(a, 0.0, MPFR_RNDN);
-    mpfr_set_d(sum_xsq_ysq, 0.0, MPFR_RNDN);
+    // frames the hardware types can resolve don't need mpfr at all 
+    switch (cp->tier)
+    {
+        case TIER_FLOAT:                 process_slice_typed<float>(cp);           return NULL;
+        case TIER_DOUBLE:                process_slice_double(cp);                 return NULL;
+        case TIER_LONG_DOUBLE:           process_slice_typed<long double>(cp);     return NULL;
+        case TIER_DOUBLE_DOUBLE:         process_slice_typed<ddouble>(cp);         return NULL;
+        case TIER_QUAD_DOUBLE:           process_slice_typed<qdouble>(cp);         return NULL;
+        case TIER_FIXED_POINT:           process_slice_fixed(cp);                  return NULL;
+        case TIER_PERTURBATION:          process_slice_perturbation<double>(cp);   return NULL;
+        case TIER_PERTURBATION_FLOATEXP: process_slice_perturbation<floatexp>(cp); return NULL;
+        default: break;
+    }
 
     for (unsigned int Dy = cp->y0; Dy < cp->y1; Dy++)
     {
-        for (unsigned int Dx = cp->x0; Dx < cp->x1; Dx++)
-        {
-            iteration = 0;
-
-            // double x0 = scaled(Dx, xsize, Xs, Xe); 
-            mpfr_sub(a, cp->Xe, cp->Xs, MPFR_RNDN);
-            mpfr_mul_d(a, a, ((double)Dx/(double)cp->x1), MPFR_RNDN);
-            mpfr_add(x0, a, cp->Xs, MPFR_RNDN);
+        bc = ((size_t)Dy * cp->xsize + cp->x0) * 3;
 
-            // double y0 = scaled(Dy, ysize, Ys, Ye); 
-            mpfr_sub(a, cp->Ye, cp->Ys, MPFR_RNDN);
-            mpfr_mul_d(a, a, ((double)Dy/(double)cp->y1), MPFR_RNDN);
-            mpfr_add(y0, a, cp->Ys, MPFR_RNDN);
+        // y0 = Ys + Dy*dy, x0 = Xs + x0*dx for the first pixel of the row 
+        mpfr_mul_ui(y0, cp->dy, Dy, MPFR_RNDN);
+        mpfr_add(y0, y0, cp->Ys, MPFR_RNDN);
+        mpfr_mul_ui(x0, cp->dx, cp->x0, MPFR_RNDN);
+        mpfr_add(x0, x0, cp->Xs, MPFR_RNDN);
+        const double yb = row_bulbs_y(cp, Dy);
 
-            // reset some vars for each pixel 
-            mpfr_set_d(x, 0.0, MPFR_RNDN);
-            mpfr_set_d(y, 0.0, MPFR_RNDN);
-            mpfr_set_d(sum_xsq_ysq, 0.0, MPFR_RNDN);
-
-            // while (xsq+ysq <= 4 && iteration < maxiter 
-            while ((mpfr_cmp_d(sum_xsq_ysq, 4.0) <= 0) && (iteration < maxiter))
-            {
-                mpfr_mul(xsq, x, x, MPFR_RNDN);      // xsq = x*x; 
-                mpfr_mul(ysq, y, y, MPFR_RNDN);      // ysq = y*y; 
-                mpfr_sub(xtmp, xsq, ysq, MPFR_RNDN); // xtemp = xsq - ysq + x0; 
-                mpfr_add(xtmp, xtmp, x0, MPFR_RNDN);
-                mpfr_mul_d(a, x, 2.0, MPFR_RNDN);    // y = 2.0*x*y + y0; 
-                mpfr_mul(a, a, y, MPFR_RNDN);
-                mpfr_add(y, a, y0, MPFR_RNDN);
-                mpfr_swap(x, xtmp);                  // x = xtemp; 
-
-                // calcs for while test 
-                mpfr_add(sum_xsq_ysq, xsq, ysq, MPFR_RNDN);
-                iteration++;
-                //printf("iteration %d\n", iteration);
+        for (unsigned int Dx = cp->x0; Dx < cp->x1; Dx++)
+        {
+            if (pixel_in_bulbs(cp, Dx, yb)) {
+                iteration = maxiter;
+            } else if (square_cross) {
+                iteration = mpfr_escape<true>(cp, x0, y0, maxiter);
+            } else {
+                iteration = mpfr_escape<false>(cp, x0, y0, maxiter);
             }
+            store_count(cp, Dx, Dy, iteration);
             // create a color value and add to result list 
             //rgb = sqrt_gradient(iteration, maxiter);
             //rgb = grayscale(iteration, maxiter);
             rgb = Ultra_Fractal_colors(iteration, maxiter);
             
             //printf("bc %d r %d\n", bc, rgb.r);
-            glb_bytearray[cp->tid][bc] = rgb.r;
+            cp->bytearray[bc] = rgb.r;
             bc++;
             //printf("bc %d g %d\n", bc, rgb.g);
-            glb_bytearray[cp->tid][bc] = rgb.g;
+            cp->bytearray[bc] = rgb.g;
             bc++;
             //printf("bc %d b %d\n", bc, rgb.b);
-            glb_bytearray[cp->tid][bc] = rgb.b;
+            cp->bytearray[bc] = rgb.b;
             bc++;
+
+            mpfr_add(x0, x0, cp->dx, MPFR_RNDN); // x0 of the next column 
         }
     }
-    mpfr_clears(x, y, xsq, ysq, xtmp, x0, y0, (mpfr_ptr)NULL);
-    mpfr_clears(a, sum_xsq_ysq, (mpfr_ptr)NULL);
-
     TRACE_DEBUGV("Exit Thread %d\n",cp->tid);
     return NULL;
 }
 
+// ----------------------------------------------------------------------------
+// process_rect - worker_process_slice on x0..x1 by y0..y1.  with an arena every
+// GMP/MPFR temporary of it comes from the arena and is dropped at the end
+//
+static void process_rect(worker_args *cp, const unsigned int x0, const unsigned int y0,
+                         const unsigned int x1, const unsigned int y1)
+{
+    cp->x0 = x0;
+    cp->x1 = x1;
+    cp->y0 = y0;
+    cp->y1 = y1;
+    if (cp->arena != NULL) {
+        MpfrMemory::enterArena(cp->arena);
+        MandelbrotMpfr::worker_process_slice(cp);
+        MpfrMemory::leaveArena();
+    } else {
+        MandelbrotMpfr::worker_process_slice(cp);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// process_line - the pixels of a one pixel high (or wide) line from (x0, y0) to
+// (x1, y1) exclusive that have no count yet, each run of them as one slice
+//
+static void process_line(worker_args *cp, const unsigned int x0, const unsigned int y0,
+                         const unsigned int x1, const unsigned int y1)
+{
+    const bool across = (y1 - y0 == 1);
+    const unsigned int length = across ? x1 - x0 : y1 - y0;
+    const size_t step = across ? 1 : cp->xsize;
+    const unsigned int *counts = cp->counts + (size_t)y0 * cp->xsize + x0;
+    unsigned int first = 0;
+
+    for (unsigned int i = 0; i <= length; i++)
+    {
+        if ((i < length) && (counts[i * step] == COUNT_UNSET)) {
+            continue;
+        }
+        if ((i > first) && across) {
+            process_rect(cp, x0 + first, y0, x0 + i, y1);
+        } else if (i > first) {
+            process_rect(cp, x0, y0 + first, x1, y0 + i);
+        }
+        first = i + 1;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// border_uniform - every pixel round the edge of r has the same count, which is
+// not a glitched one
+//
+static bool border_uniform(const worker_args *cp, const Tile &r, unsigned int *count)
+{
+    const unsigned int *counts = cp->counts;
+    const size_t xsize = cp->xsize;
+    const unsigned int c = counts[(size_t)r.y0 * xsize + r.x0];
+
+    if (c == COUNT_GLITCHED) {
+        return false;
+    }
+    for (unsigned int x = r.x0; x < r.x1; x++)
+    {
+        if ((counts[(size_t)r.y0 * xsize + x] != c) || (counts[(size_t)(r.y1 - 1) * xsize + x] != c)) {
+            return false;
+        }
+    }
+    for (unsigned int y = r.y0 + 1; y < r.y1 - 1; y++)
+    {
+        if ((counts[(size_t)y * xsize + r.x0] != c) || (counts[(size_t)y * xsize + r.x1 - 1] != c)) {
+            return false;
+        }
+    }
+    *count = c;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// process_subdivided - Mariani-Silver on the rectangle r.  its border is worked
+// out (all of it for a tile from reset, none for one from a split), and if the
+// border is one count the inside is filled with it without iterating.  else the
+// middle row and column are worked out and the four quarters, which share them
+// as borders, go back on the worker's deque as new tiles.  the insides of the
+// quarters don't overlap so no pixel is ever done twice, and the same splits
+// happen whatever worker runs them, so the frame doesn't depend on ncpus
+//
+static void process_subdivided(worker_args *cp, const unsigned int tid, const Tile &r)
+{
+    const unsigned int w = r.x1 - r.x0;
+    const unsigned int h = r.y1 - r.y0;
+    unsigned int count;
+
+    process_line(cp, r.x0, r.y0, r.x1, r.y0 + 1);
+    process_line(cp, r.x0, r.y1 - 1, r.x1, r.y1);
+    process_line(cp, r.x0, r.y0, r.x0 + 1, r.y1);
+    process_line(cp, r.x1 - 1, r.y0, r.x1, r.y1);
+    if ((w <= 2) || (h <= 2)) {
+        return; // all border
+    }
+
+    if (border_uniform(cp, r, &count)) {
+        Color rgb = Ultra_Fractal_colors(count, cp->maxiter);
+        for (unsigned int Dy = r.y0 + 1; Dy < r.y1 - 1; Dy++)
+        {
+            size_t bc = ((size_t)Dy * cp->xsize + r.x0 + 1) * 3;
+            for (unsigned int Dx = r.x0 + 1; Dx < r.x1 - 1; Dx++)
+            {
+                cp->counts[(size_t)Dy * cp->xsize + Dx] = count;
+                cp->bytearray[bc++] = rgb.r;
+                cp->bytearray[bc++] = rgb.g;
+                cp->bytearray[bc++] = rgb.b;
+            }
+        }
+        cp->filled += (w - 2) * (h - 2);
+        return;
+    }
+
+    if ((w < SUBDIVIDE_MIN_SIZE) || (h < SUBDIVIDE_MIN_SIZE)) {
+        process_rect(cp, r.x0 + 1, r.y0 + 1, r.x1 - 1, r.y1 - 1);
+        return;
+    }
+
+    const unsigned int mx = r.x0 + w / 2;
+    const unsigned int my = r.y0 + h / 2;
+    process_line(cp, r.x0 + 1, my, r.x1 - 1, my + 1);
+    process_line(cp, mx, r.y0 + 1, mx + 1, r.y1 - 1);
+    const Tile quarters[4] = { { r.x0, r.y0, mx + 1, my + 1 }, { mx, r.y0, r.x1, my + 1 },
+                               { r.x0, my, mx + 1, r.y1 },     { mx, my, r.x1, r.y1 } };
+    for (const Tile &quarter : quarters)
+    {
+        cp->scheduler->push(tid, quarter);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// worker_frame_job (run by every thread in the pool)
+//
+// the pool hands each worker its thread id, use it to pick out that worker's
+// worker_args then keep pulling tiles from the scheduler (own deque first,
+// stealing once it is empty) until the frame has no work left.  a subdivided
+// frame's tiles are rectangles that may split into more
+//
+void MandelbrotMpfr::worker_frame_job(void* arg, const unsigned int tid)
+{
+    worker_args *cp = &(((worker_args*)arg)[tid]);
+    Tile tile;
+
+    while (cp->scheduler->next(tid, &tile))
+    {
+        if (cp->counts != NULL) {
+            process_subdivided(cp, tid, tile);
+        } else {
+            process_rect(cp, tile.x0, tile.y0, tile.x1, tile.y1);
+        }
+        cp->scheduler->done();
+    }
+}
+
+// ----------------------------------------------------------------------------
+// worker_glitch_job (run by every thread in the pool)
+//
+// one pass over the glitched pixels of a perturbation frame, every worker
+// takes its own contiguous share of the list
+//
+void MandelbrotMpfr::worker_glitch_job(void* arg, const unsigned int tid)
+{
+    worker_args *cp = &(((worker_args*)arg)[tid]);
+
+    cp->glitched.clear();
+    if (cp->tier == TIER_PERTURBATION_FLOATEXP) {
+        process_glitches<floatexp>(cp);
+    } else {
+        process_glitches<double>(cp);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// gather_glitches - every worker's glitched pixels into m_glitchPixels
+//
+void MandelbrotMpfr::gather_glitches()
+{
+    m_glitchPixels.clear();
+    for (int tid = 0; tid < ncpus; tid++)
+    {
+        std::vector<unsigned int> &glitched = m_wargs[tid].glitched;
+        m_glitchPixels.insert(m_glitchPixels.end(), glitched.begin(), glitched.end());
+    }
+}
+
+// ----------------------------------------------------------------------------
+// resolve_glitches - after the main pass of a GLITCH_REFERENCES frame, take the
+// glitched pixel nearest the middle of them all as a new reference and redo
+// just the glitched pixels against it, until none are left or there have been
+// GLITCH_MAX_REFERENCES of them.  each pass costs one mpfr orbit and the
+// glitched pixels, the rest of the frame is never touched again.
+//
+void MandelbrotMpfr::resolve_glitches(const unsigned int xsize, const unsigned int ysize)
+{
+    gather_glitches();
+    m_glitchedPixels = (unsigned int)m_glitchPixels.size();
+    for (int tid = 0; tid < ncpus; tid++)
+    {
+        m_glitchedPixels += m_wargs[tid].rebased;
+    }
+    m_glitchReferences = 0;
+
+    while ((m_glitchMode == GLITCH_REFERENCES) && !m_glitchPixels.empty() && 
+           (m_glitchReferences < GLITCH_MAX_REFERENCES))
+    {
+        double mx = 0.0, my = 0.0;
+        for (unsigned int pixel : m_glitchPixels)
+        {
+            mx += (double)(pixel % xsize);
+            my += (double)(pixel / xsize);
+        }
+        mx /= (double)m_glitchPixels.size();
+        my /= (double)m_glitchPixels.size();
+
+        unsigned int ref = m_glitchPixels[0];
+        double best = -1.0;
+        for (unsigned int pixel : m_glitchPixels)
+        {
+            double ex = (double)(pixel % xsize) - mx;
+            double ey = (double)(pixel / xsize) - my;
+            if ((best < 0.0) || (ex*ex + ey*ey < best)) {
+                best = ex*ex + ey*ey;
+                ref = pixel;
+            }
+        }
+
+        // c of that pixel as the workers place it, Xs + Dx*dx (Xe_Xs, Ye_Ys are scratch)
+        worker_args *cp0 = &(m_wargs[0]);
+        mpfr_mul_ui(Xe_Xs, cp0->dx, ref % xsize, MPFR_RNDN);
+        mpfr_add(Xe_Xs, Xe_Xs, Xs, MPFR_RNDN);
+        mpfr_mul_ui(Ye_Ys, cp0->dy, ref / xsize, MPFR_RNDN);
+        mpfr_add(Ye_Ys, Ye_Ys, Ys, MPFR_RNDN);
+        m_glitchOrbit->setCompressed(compress_orbits());
+        m_glitchOrbit->compute(Xe_Xs, Ye_Ys, m_framePrecision, m_maxIter);
+        TRACE_DEBUGV("%zu glitched pixels, reference at %u\n", m_glitchPixels.size(), ref);
+
+        for (int tid = 0; tid < ncpus; tid++)
+        {
+            worker_args *cp = &(m_wargs[tid]);
+            cp->orbit = m_glitchOrbit;
+            cp->redo = m_glitchPixels.data();
+            cp->redo_count = (unsigned int)m_glitchPixels.size();
+            cp->ref_x = ref % xsize;
+            cp->ref_y = ref / xsize;
+        }
+        m_pool->runFrame(worker_glitch_job, m_wargs);
+        m_glitchReferences++;
+        gather_glitches();
+    }
+    m_unresolvedGlitches = (m_glitchMode == GLITCH_REFERENCES) ? (unsigned int)m_glitchPixels.size() : 0;
+}
+
+// ----------------------------------------------------------------------------
+// switch the per worker arenas on or off, the worker state is rebuilt on the
+// next frame
+//
+void MandelbrotMpfr::setUseArena(const bool useArena)
+{
+    if (useArena != m_useArena) {
+        m_useArena = useArena;
+        free_worker_state();
+    }
+}
+
+// ----------------------------------------------------------------------------
+// pick the row kernels for the double and fixed point tiers, never wider than the cpu can run
+//
+void MandelbrotMpfr::setSimdLevel(const SimdLevel level)
+{
+    SimdLevel best = simd_best_level();
+    m_simdLevel = (level > best) ? best : level;
+}
+
+// ----------------------------------------------------------------------------
+// turn the cycle check on or off for one tier, or for all of them with TIER_AUTO
+//
+void MandelbrotMpfr::setUsePeriodicity(const NumericTier tier, const bool usePeriodicity)
+{
+    unsigned int bits = (tier == TIER_AUTO) ? ~0u : (1u << tier);
+    m_periodicTiers = usePeriodicity ? (m_periodicTiers | bits) : (m_periodicTiers & ~bits);
+}
+
+// ----------------------------------------------------------------------------
+// change the number of worker threads, the pool and the tile deques are
+// rebuilt to match
+//
+void MandelbrotMpfr::setNcpus(const int cpus)
+{
+    ncpus = (cpus < 1) ? 1 : cpus;
+    free_worker_state();
+    delete m_scheduler;
+    delete m_pool;
+    m_pool = new ThreadPool(ncpus);
+    m_scheduler = new TileScheduler(ncpus);
+}
+
 
 /* ----------------------------------------------------------------------------
- * mandelbrot set using mpfr library, but 4 threads
+ * mandelbrot set using mpfr library, on the thread pool
  *
- * Description - the data area is cut into quarters although this is not the
- *               easiest split to manage as putting the results back together
- *               is non trivial.  would be better to use horizontal slices.
- *
- *               the setting up of the params for the threads is currently a
- *               bit long-winded and only copes with 4 threads.  Need to use
- *               a loop along with arrays of structures to provide flexibility
- *               to cope with any number of CPU cores
+ * Description - the frame is cut into TILE_SIZE square tiles which are dealt
+ *               out to per worker deques by the TileScheduler.  Workers that
+ *               run out of tiles steal from the others, so a band with lots
+ *               of boundary detail no longer holds up the whole frame.  The
+ *               pixel coordinates come from the whole frame, not the tile,
+ *               so the image is the same whatever the number of cores.
+ *               Each worker writes its pixels directly into bytearray.
+ *               Worker state persists between frames so a frame at an
+ *               unchanged precision and size makes no heap allocations.
+ *               The frame runs in the cheapest NumericTier that resolves
+ *               its pixel spacing, mpfr (or perturbation against one mpfr
+ *               reference orbit) only once the hardware types can't.
+ *               Pixels of a perturbation frame that lose the reference are
+ *               rebased, or redone against more references (m_glitchMode).
  * Params
  * xsize, ysize   - width and height of fractal
- * maxiter        - the maximum iterations before escaping the algorithm
- * use_threads    - decide whether to use threading to improve performance
  *
  * (out)bytearray - a bytearray of ints storing the color values of calculated points
  *
@@ -653,12 +1769,7 @@ void MandelbrotMpfr::mandelbrot_mpfr_c(
                 unsigned char **bytearray   // reference/pointer to result list of color values 
                )
 {
-    unsigned int bc = 0;
-    mpfr_t lx, ly, yslice, ys1, ye1;
-    mpfr_inits2(PRECISION, lx, ly, yslice, ys1, ye1, (mpfr_ptr)NULL);
-
-    //printf("mandelbrot_mpfr_main_c (%s) Entry\n", use_threads?"Threaded":"Single");
-    TRACE_DEBUGV("mandelbrot_mpfr_main_c (%s) Entry\n", use_threads?"Threaded":"Single");
+    TRACE_DEBUG("mandelbrot_mpfr_main_c Entry\n");
 
 #ifdef TRACE
     mpfr_out_str(stdout, 10, 0, Xs, MPFR_RNDN); std::cout << "\n";
@@ -668,95 +1779,164 @@ void MandelbrotMpfr::mandelbrot_mpfr_c(
     std::cout << "\n";
 #endif
     
-    unsigned int core_count = 1;
-    unsigned int nslice = 1;
-    
-    core_count = ncpus;
-    nslice = core_count;
+    unsigned long allocations = MpfrMemory::allocations();
+    unsigned int core_count = ncpus;
 
     //printf("core_count = %d\n", core_count);
-    std::vector<std::thread> threads;
-
-    worker_args wargs[core_count];
+    update_precision(xsize);
+    m_frameTier = select_tier();
+    m_fixedLimbs = (m_frameTier == TIER_FIXED_POINT) ? fixed_limbs(m_framePrecision) : 0;
+    prepare_worker_state();
+
+    // the one mpfr orbit of a perturbation frame, and how far pixel (0,0) is
+    // from it (Xe_Xs, Ye_Ys are free as scratch here).  then how far down the
+    // orbit the series approximation lets every pixel start
+    floatexp dcx0, dcy0;
+    m_frameSkip = 0;
+    m_orbitReused = false;
+    m_orbitCached = false;
+    if (m_frameTier >= TIER_PERTURBATION) {
+        compute_reference();
+        mpfr_sub(Xe_Xs, Xs, CX, MPFR_RNDN);
+        mpfr_sub(Ye_Ys, Ys, CY, MPFR_RNDN);
+        dcx0 = get_floatexp(Xe_Xs);
+        dcy0 = get_floatexp(Ye_Ys);
+        if (m_useSeries) {
+            mpfr_sub(Xe_Xs, Xe, Xs, MPFR_RNDN);
+            mpfr_div_ui(Xe_Xs, Xe_Xs, xsize, MPFR_RNDN);
+            mpfr_sub(Ye_Ys, Ye, Ys, MPFR_RNDN);
+            mpfr_div_ui(Ye_Ys, Ye_Ys, ysize, MPFR_RNDN);
+            m_frameSkip = m_series->compute(m_orbit, dcx0, dcy0, get_floatexp(Xe_Xs), get_floatexp(Ye_Ys), 
+                                            xsize, ysize, m_maxIter);
+        }
+    }
+    m_skippedIterations = (unsigned long long)m_frameSkip * xsize * ysize;
+
+    // and the BLA table, for the largest |dc| in the frame (one of the corners)
+    const void *bla = NULL;
+    m_blaBytes = 0;
+    if (m_frameTier >= TIER_PERTURBATION && m_useBla) {
+        mpfr_sub(Xe_Xs, Xe, CX, MPFR_RNDN);
+        mpfr_sub(Ye_Ys, Ye, CY, MPFR_RNDN);
+        floatexp cx[2] = { abs(dcx0), abs(get_floatexp(Xe_Xs)) };
+        floatexp cy[2] = { abs(dcy0), abs(get_floatexp(Ye_Ys)) };
+        floatexp dcmax = sqrt(((cx[0] < cx[1]) ? cx[1] * cx[1] : cx[0] * cx[0]) + 
+                              ((cy[0] < cy[1]) ? cy[1] * cy[1] : cy[0] * cy[0]));
+        if (m_frameTier == TIER_PERTURBATION) {
+            m_bla->build(m_orbit, dcmax, m_blaCap);
+            m_blaBytes = m_bla->bytes();
+            bla = m_bla;
+        } else {
+            m_blaFe->build(m_orbit, dcmax, m_blaCap);
+            m_blaBytes = m_blaFe->bytes();
+            bla = m_blaFe;
+        }
+    }
     
-    mpfr_set_d(yslice, 0.0, MPFR_RNDN);
-    mpfr_sub(yslice, Ye, Ys, MPFR_RNDN);
-    mpfr_div_ui(yslice, yslice, nslice, MPFR_RNDN);
-
-    // initialise the global bytearray 
-    glb_bytearray = (unsigned char**)malloc(core_count*sizeof(unsigned char*));
-    for(unsigned int slice=0; slice<core_count; slice++)
-    {
-        glb_bytearray[slice] = (unsigned char*)calloc((size_t)(xsize * ysize/core_count * 3), sizeof(unsigned char));
-
-        wargs[slice].tid = slice;
-        wargs[slice].cpus = core_count;
-        wargs[slice].maxiter = m_maxIter;
-        wargs[slice].precision = PRECISION;
-        wargs[slice].x0 = 0;
-        wargs[slice].x1 = xsize;
-        wargs[slice].y0 = 0;
-        wargs[slice].y1 = (ysize/nslice);
-      
-        mpfr_inits2(PRECISION, wargs[slice].Xe, wargs[slice].Xs, wargs[slice].Ye, wargs[slice].Ys, (mpfr_ptr)NULL);
-        mpfr_set(wargs[slice].Xs, Xs, MPFR_RNDN);
-        mpfr_set(wargs[slice].Xe, Xe, MPFR_RNDN);
+    // the cycle check's tolerance, a power of two well under the pixel spacing
+    // so an orbit only counts as periodic once it is settled to below a pixel
+    long periodExp = (long)m_pixelExp - PERIODICITY_BITS;
+    if (!getUsePeriodicity(m_frameTier) || (m_frameTier >= TIER_PERTURBATION) || (periodExp >= 0)) {
+        periodExp = 0;
+    }
 
-        if (nslice > 1)
-        {
-            // Ys + n*yslice 
-            mpfr_mul_ui(ys1, yslice, slice, MPFR_RNDN);
-            mpfr_add(wargs[slice].Ys, ys1, Ys, MPFR_RNDN);
-            // Ys + (n+1)*yslice 
-            mpfr_mul_ui(ye1, yslice, slice+1, MPFR_RNDN);
-            mpfr_add(wargs[slice].Ye, ye1, Ys, MPFR_RNDN);
-        }
-        else
+    // a subdivided frame starts from bigger tiles, with every count unset.  a split
+    // rectangle's quarters are at most half its size plus the shared line, and only
+    // rectangles SUBDIVIDE_MIN_SIZE or more across split
+    unsigned int depth = 0;
+    if (m_useSubdivision) {
+        if (m_counts.size() != (size_t)xsize * ysize) {
+            m_counts.resize((size_t)xsize * ysize);
+        }
+        std::fill(m_counts.begin(), m_counts.end(), COUNT_UNSET);
+        for (unsigned int size = SUBDIVIDE_TILE_SIZE; size >= SUBDIVIDE_MIN_SIZE; size = size / 2 + 1)
         {
-            mpfr_set(wargs[slice].Ys, Ys, MPFR_RNDN);
-            mpfr_set(wargs[slice].Ye, Ye, MPFR_RNDN);
+            depth++;
         }
-#ifdef TRACE
-        mpfr_out_str(stdout, 10, 0, Xs, MPFR_RNDN); std::cout << "\n";
-        mpfr_out_str(stdout, 10, 0, Xe, MPFR_RNDN); std::cout << "\n";
-        mpfr_out_str(stdout, 10, 0, Ys, MPFR_RNDN); std::cout << "\n";
-        mpfr_out_str(stdout, 10, 0, Ye, MPFR_RNDN); std::cout << "\n";
-        std::cout << "\n";
-#endif
-        
-        threads.push_back(std::thread(worker_process_slice, &(wargs[slice])));
     }
+    m_scheduler->reset(xsize, ysize, m_useSubdivision ? SUBDIVIDE_TILE_SIZE : TILE_SIZE, depth);
+    TRACE_DEBUGV("%d tiles\n", m_scheduler->tileCount());
 
-    // ------------------------------------------------------------------------- 
-
-    // wait for all the threads to complete 
-    for (auto& th : threads) th.join();
-        
-    // populate the returned bytearray from the global one 
-    TRACE_DEBUG("Combining Results\n");
-    bc = 0;
-    for(unsigned int slice=0; slice<core_count; slice++)
+    for(unsigned int tid=0; tid<core_count; tid++)
     {
-        for(unsigned int gbc=0; gbc < xsize*3*(ysize/core_count); gbc++)
-        {
-            (*bytearray)[bc] = glb_bytearray[slice][gbc]; bc++;
+        worker_args *cp = &(m_wargs[tid]);
+        cp->tid = tid;
+        cp->cpus = core_count;
+        cp->maxiter = m_maxIter;
+        cp->precision = m_framePrecision;
+        cp->xsize = xsize;
+        cp->ysize = ysize;
+        cp->scheduler = m_scheduler;
+        cp->bytearray = *bytearray;
+      
+        mpfr_set(cp->Xs, Xs, MPFR_RNDN);
+        mpfr_set(cp->Xe, Xe, MPFR_RNDN);
+        mpfr_set(cp->Ys, Ys, MPFR_RNDN);
+        mpfr_set(cp->Ye, Ye, MPFR_RNDN);
+
+        // pixel spacing for the frame, dx = (Xe-Xs)/xsize, dy = (Ye-Ys)/ysize
+        mpfr_sub(cp->dx, Xe, Xs, MPFR_RNDN);
+        mpfr_div_ui(cp->dx, cp->dx, xsize, MPFR_RNDN);
+        mpfr_sub(cp->dy, Ye, Ys, MPFR_RNDN);
+        mpfr_div_ui(cp->dy, cp->dy, ysize, MPFR_RNDN);
+
+        cp->tier = m_frameTier;
+        cp->escape_row = simd_escape_row(m_simdLevel);
+        cp->escape_column = simd_escape_column(m_simdLevel);
+        cp->fixed_row = fixed_escape_row(m_fixedLimbs, m_simdLevel);
+        cp->fixed_column = fixed_escape_column(m_fixedLimbs, m_simdLevel);
+        cp->orbit = m_orbit;
+        cp->dcx0 = dcx0;
+        cp->dcy0 = dcy0;
+        cp->dx_fe = get_floatexp(cp->dx);
+        cp->dy_fe = get_floatexp(cp->dy);
+        cp->series = m_series;
+        cp->series_skip = m_frameSkip;
+        cp->bla = bla;
+        cp->glitch = m_glitchMode;
+        cp->glitched.clear();
+        cp->rebased = 0;
+        cp->reject_bulbs = m_useBulbRejection;
+        cp->rejected = 0;
+        cp->period_exp = periodExp;
+        cp->counts = m_useSubdivision ? m_counts.data() : NULL;
+        cp->filled = 0;
+        cp->Xs_ld = get_long_double(cp->Xs, cp->a);
+        cp->Ys_ld = get_long_double(cp->Ys, cp->a);
+        cp->dx_ld = get_long_double(cp->dx, cp->a);
+        cp->dy_ld = get_long_double(cp->dy, cp->a);
+        if ((m_frameTier == TIER_DOUBLE_DOUBLE) || (m_frameTier == TIER_QUAD_DOUBLE)) {
+            cp->Xs_qd = get_qdouble(cp->Xs, cp->a);
+            cp->Ys_qd = get_qdouble(cp->Ys, cp->a);
+            cp->dx_qd = get_qdouble(cp->dx, cp->a);
+            cp->dy_qd = get_qdouble(cp->dy, cp->a);
         }
     }
 
-    // free the global bytearray
-    TRACE_DEBUG("Freeing glb_bytearray\n");
-    for(unsigned int slice=0; slice<core_count; slice++)
+    // ------------------------------------------------------------------------- 
+
+    // wake the pool and wait for every tile of the frame to be done
+    m_pool->runFrame(worker_frame_job, m_wargs);
+
+    m_rejectedPixels = 0;
+    m_filledPixels = 0;
+    for (unsigned int tid = 0; tid < core_count; tid++)
     {
-        mpfr_clears(wargs[slice].Xe, wargs[slice].Xs, wargs[slice].Ye, wargs[slice].Ys, (mpfr_ptr)NULL);
-        free(glb_bytearray[slice]); // = (int*)calloc((size_t)(xsize/2 * ysize/2 * 3), sizeof(int));
+        m_rejectedPixels += m_wargs[tid].rejected;
+        m_filledPixels += m_wargs[tid].filled;
     }
-    free(glb_bytearray);
 
-    // clear (free) mpfr data
-    mpfr_clears(lx, ly, yslice, ys1, ye1, (mpfr_ptr)NULL);
-    
-    TRACE_DEBUGV("mandelbrot_mpfr_main_c (%s) Exit\n", use_threads?"Threaded":"Single");
-    //printf("mandelbrot_mpfr_main_c (%s) Exit\n", use_threads?"Threaded":"Single");
+    m_glitchedPixels = 0;
+    m_glitchReferences = 0;
+    m_unresolvedGlitches = 0;
+    if (m_frameTier >= TIER_PERTURBATION) {
+        resolve_glitches(xsize, ysize);
+    }
+
+    m_frameAllocations = MpfrMemory::allocations() - allocations;
+    TRACE_DEBUGV("%lu allocations\n", m_frameAllocations);
+
+    TRACE_DEBUG("mandelbrot_mpfr_main_c Exit\n");
 }
 
 
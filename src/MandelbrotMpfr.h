@@ -1,9 +1,47 @@
 // a class to support  
 
-#define DEFAULT_PRECISION  512
+#ifndef MANDELBROT_MPFR_H
+#define MANDELBROT_MPFR_H
+
+#define DEFAULT_PRECISION  512 // starting precision of the view (corners and centre)
 #define DEFAULT_MAXITER   1000
+#define MIN_PRECISION       64 // lowest precision a frame is computed at
+#define PRECISION_GUARD_BITS 32 // bits kept beyond those that resolve one pixel
+#define TIER_GUARD_BITS     12 // spare mantissa bits a hardware type must have
+#define PERIODICITY_BITS     8 // the cycle check's tolerance is the pixel spacing / 2^PERIODICITY_BITS
+#define SUBDIVIDE_TILE_SIZE 64 // rectangles a subdivided frame starts from
+#define SUBDIVIDE_MIN_SIZE   8 // narrower ones are worked out whole rather than split
+#define GLITCH_MAX_REFERENCES 32 // extra references a GLITCH_REFERENCES frame may use
+#define ORBIT_COMPRESS_MAXITER (1 << 24) // ORBIT_STORAGE_AUTO compresses orbits from here (256 MB)
+
+// numeric types a frame can be computed in, cheapest first.  TIER_DOUBLE_DOUBLE and
+// TIER_QUAD_DOUBLE hold each value as the sum of two and four doubles (see
+// DoubleDouble.h, QuadDouble.h), TIER_FIXED_POINT runs the mpfr loop in fixed point
+// (see EscapeTimeFixed.h), TIER_PERTURBATION iterates one mpfr reference orbit and
+// every pixel's double offset from it,
+// TIER_PERTURBATION_FLOATEXP holds the offsets as floatexp once they underflow a double
+enum NumericTier { TIER_AUTO, TIER_FLOAT, TIER_DOUBLE, TIER_LONG_DOUBLE, TIER_DOUBLE_DOUBLE, TIER_QUAD_DOUBLE,
+                   TIER_FIXED_POINT, TIER_MPFR, TIER_PERTURBATION, TIER_PERTURBATION_FLOATEXP };
+
+// how reference orbits are held, every point or only waypoints (see ReferenceOrbit.h).
+// ORBIT_STORAGE_AUTO compresses them once maxiter reaches ORBIT_COMPRESS_MAXITER
+enum OrbitStorage { ORBIT_STORAGE_AUTO, ORBIT_STORAGE_FULL, ORBIT_STORAGE_COMPRESSED };
 
+#include <vector>
+#include <string>
 #include "mpfr.h"
+#include "ThreadPool.h"
+#include "TileScheduler.h"
+#include "MpfrMemory.h"
+#include "EscapeTimeSimd.h"
+#include "EscapeTimeFixed.h"
+#include "ReferenceOrbit.h"
+#include "OrbitCache.h"
+#include "SeriesApproximation.h"
+#include "BlaTable.h"
+#include "Perturbation.h"
+
+struct worker_args;
 
 class MandelbrotMpfr
 {
@@ -12,19 +50,65 @@ public:
      : m_maxIter(maxiter),
        m_zoom_factor(zoom_factor),
        zoom_level(0),
-       ncpus(1)
+       ncpus(1),
+       m_wargs(NULL),
+       m_wargsCount(0),
+       m_wargsPrecision(0),
+       m_frameAllocations(0),
+       m_useArena(false),
+       m_useFixedPoint(false),
+       m_fixedLimbs(0),
+       m_usePerturbation(false),
+       m_reuseOrbit(true),
+       m_referencePrecision(0),
+       m_orbitReused(false),
+       m_orbitCache(NULL),
+       m_orbitCached(false),
+       m_orbitStored(0),
+       m_orbitStorage(ORBIT_STORAGE_AUTO),
+       m_useSeries(true),
+       m_frameSkip(0),
+       m_skippedIterations(0),
+       m_useBla(false),
+       m_blaCap(BLA_DEFAULT_CAP),
+       m_blaBytes(0),
+       m_glitchMode(GLITCH_REBASE),
+       m_glitchedPixels(0),
+       m_glitchReferences(0),
+       m_unresolvedGlitches(0),
+       m_useBulbRejection(true),
+       m_rejectedPixels(0),
+       m_periodicTiers(~0u),
+       m_useSubdivision(false),
+       m_filledPixels(0)
      { 
         PRECISION = precision;
-        if(PRECISION < DEFAULT_PRECISION) {
-            PRECISION = DEFAULT_PRECISION;
+        if(PRECISION < MIN_PRECISION) {
+            PRECISION = MIN_PRECISION;
         }
+        m_viewPrecision = (PRECISION < DEFAULT_PRECISION) ? DEFAULT_PRECISION : PRECISION;
+        m_framePrecision = PRECISION;
+        m_pixelBits = 0;
+        m_pixelExp = 0;
+        m_tier = TIER_AUTO;
+        m_frameTier = TIER_MPFR;
+        m_simdLevel = simd_default_level();
         if(m_maxIter < DEFAULT_MAXITER) {
             m_maxIter = DEFAULT_MAXITER;
         }
         ncpus = cpuCount();
+        MpfrMemory::install();
         initialise_mpfr_vars();
+        m_pool = new ThreadPool(ncpus);
+        m_scheduler = new TileScheduler(ncpus);
+        m_orbit = new ReferenceOrbit();
+        m_series = new SeriesApproximation();
+        m_bla = new BlaTable<double>();
+        m_blaFe = new BlaTable<floatexp>();
+        m_glitchOrbit = new ReferenceOrbit();
      }
-    ~MandelbrotMpfr(){}
+    ~MandelbrotMpfr(){ free_worker_state(); delete m_orbitCache; delete m_glitchOrbit; delete m_blaFe; delete m_bla; delete m_series; 
+                       delete m_orbit; delete m_scheduler; delete m_pool; }
 
     void mandelbrot_mpfr_c( 
                         const unsigned int xsize,   // width of screen/display/window 
@@ -49,21 +133,155 @@ public:
                         const char* Cy_str); // string repr of centre Y pos for zooming in 
                
     static void* worker_process_slice(void* arg);
+    static void worker_frame_job(void* arg, const unsigned int tid);
+    static void worker_glitch_job(void* arg, const unsigned int tid);
 
     // Setter and Getters
     void setMaxIter(const int maxiter) {m_maxIter = maxiter;}
+    // the minimum precision, each frame uses more if its pixel spacing needs it
     void setPrecision(const int precision) {PRECISION = precision;}
     const int getMaxIter() {return m_maxIter;}
     const int getPrecision() {return PRECISION;}
+    const int getFramePrecision() {return m_framePrecision;}
+    // bits needed to tell neighbouring pixels of the last frame apart
+    const int getPixelBits() {return m_pixelBits;}
+    // TIER_AUTO picks the cheapest type that resolves the pixel spacing every frame
+    void setTier(const NumericTier tier) {m_tier = tier;}
+    const NumericTier getFrameTier() {return m_frameTier;}
+    static const char* tierName(const NumericTier tier);
+    // instruction set of the double and fixed point tiers, clamped to what the cpu supports
+    void setSimdLevel(const SimdLevel level);
+    const SimdLevel getSimdLevel() {return m_simdLevel;}
     const int getNcpus() {return ncpus;}
+    void setNcpus(const int cpus);
+    // GMP/MPFR heap allocations made by the last call to mandelbrot_mpfr_c
+    const unsigned long getFrameAllocations() {return m_frameAllocations;}
+    // serve GMP/MPFR temporaries from a per worker arena, reset after every tile
+    void setUseArena(const bool useArena);
+    const bool getUseArena() {return m_useArena;}
+    // frames too deep for the hardware types run as TIER_FIXED_POINT, not TIER_MPFR,
+    // where the view is inside it and needs no more than FIXED_MAX_LIMBS limbs
+    void setUseFixedPoint(const bool useFixedPoint) {m_useFixedPoint = useFixedPoint;}
+    const bool getUseFixedPoint() {return m_useFixedPoint;}
+    // limbs of the kernel the last TIER_FIXED_POINT frame ran, 0 after any other
+    const int getFixedLimbs() {return m_fixedLimbs;}
+    // frames too deep for the hardware types run as TIER_PERTURBATION, not TIER_MPFR
+    void setUsePerturbation(const bool usePerturbation) {m_usePerturbation = usePerturbation;}
+    const bool getUsePerturbation() {return m_usePerturbation;}
+    // points in the reference orbit of the last perturbation frame
+    const unsigned int getOrbitLength() {return m_orbit->length();}
+    // least precision of a reference orbit.  a zoom into a fixed point sets it to that
+    // of its deepest frame (see planZoomSequence) so the one orbit serves every frame
+    void setReuseOrbit(const bool reuseOrbit) {m_reuseOrbit = reuseOrbit;}
+    void setReferencePrecision(const int bits) {m_referencePrecision = bits;}
+    const int getReferencePrecision() {return m_referencePrecision;}
+    void planZoomSequence(const unsigned int zooms, const unsigned int xsize);
+    // true if the last frame used the orbit of the frame before (extended if need be)
+    const bool getOrbitReused() {return m_orbitReused;}
+    // look for reference orbits in, and save them to, files under directory (see
+    // OrbitCache.h).  "" turns it off, as it is to start with
+    void setOrbitCache(const std::string &directory, const size_t capacity = ORBIT_CACHE_DEFAULT_CAPACITY);
+    OrbitCache* getOrbitCache() {return m_orbitCache;}
+    // true if the last frame's reference orbit was loaded from the cache
+    const bool getOrbitCached() {return m_orbitCached;}
+    void setOrbitStorage(const OrbitStorage storage) {m_orbitStorage = storage;}
+    const OrbitStorage getOrbitStorage() {return m_orbitStorage;}
+    // memory held by the points of the last frame's reference orbit
+    const size_t getOrbitBytes() {return m_orbit->bytes();}
+    const bool getOrbitCompressed() {return m_orbit->compressed();}
+    // let perturbation frames start every pixel part way down the orbit
+    void setUseSeries(const bool useSeries) {m_useSeries = useSeries;}
+    const bool getUseSeries() {return m_useSeries;}
+    // iterations each pixel of the last frame skipped, and the total over the frame
+    const unsigned int getSeriesSkip() {return m_frameSkip;}
+    const unsigned long long getSkippedIterations() {return m_skippedIterations;}
+    // let perturbation frames jump along the orbit with a BLA table of at most cap bytes
+    void setUseBla(const bool useBla) {m_useBla = useBla;}
+    const bool getUseBla() {return m_useBla;}
+    void setBlaMemoryCap(const size_t cap) {m_blaCap = cap;}
+    // size of the table used by the last frame, 0 if it had none
+    const size_t getBlaBytes() {return m_blaBytes;}
+    // how perturbation frames find and fix pixels that lost the reference orbit
+    void setGlitchMode(const GlitchMode mode) {m_glitchMode = mode;}
+    const GlitchMode getGlitchMode() {return m_glitchMode;}
+    // pixels of the last frame that lost the reference, the extra references used
+    // to redo them and those still glitched when GLITCH_MAX_REFERENCES ran out
+    const unsigned int getGlitchedPixels() {return m_glitchedPixels;}
+    const unsigned int getGlitchReferences() {return m_glitchReferences;}
+    const unsigned int getUnresolvedGlitches() {return m_unresolvedGlitches;}
+    // every tier writes pixels inside the main cardioid or the period 2 bulb straight
+    // as interior, without iterating (see in_main_bulbs in EscapeTime.h)
+    void setUseBulbRejection(const bool useBulbRejection) {m_useBulbRejection = useBulbRejection;}
+    const bool getUseBulbRejection() {return m_useBulbRejection;}
+    // pixels of the last frame rejected that way
+    const unsigned int getRejectedPixels() {return m_rejectedPixels;}
+    // the escape loop of tier (every tier for TIER_AUTO) checks the orbit for a
+    // cycle and stops at the first, see calculate_point in EscapeTime.h.  on for
+    // all by default, the perturbation tiers never check
+    void setUsePeriodicity(const NumericTier tier, const bool usePeriodicity);
+    const bool getUsePeriodicity(const NumericTier tier) {return (m_periodicTiers >> tier) & 1u;}
+    // Mariani-Silver: only the borders of rectangles are worked out, one whose border
+    // is all one count is filled with it and any other is split in four
+    void setUseSubdivision(const bool useSubdivision) {m_useSubdivision = useSubdivision;}
+    const bool getUseSubdivision() {return m_useSubdivision;}
+    // pixels of the last frame filled that way
+    const unsigned int getFilledPixels() {return m_filledPixels;}
 
 private:
     // Attributes
-    int PRECISION;
+    int PRECISION;        // floor for m_framePrecision
+    int m_framePrecision; // bits the workers use, derived from the zoom depth
+    int m_viewPrecision;  // bits of the corner/centre vars, only ever grows
+    int m_pixelBits;      // bits from the largest corner down to the pixel spacing
+    int m_pixelExp;       // binary exponent of the pixel spacing
+    NumericTier m_tier;      // requested tier
+    NumericTier m_frameTier; // tier the last frame ran in
+    SimdLevel m_simdLevel;   // row kernels used by the double and fixed point tiers
     int m_maxIter;
     int m_zoom_factor;
     int zoom_level; // = 0;
     int ncpus; // = 1; // just to be safe 
+    ThreadPool *m_pool; // ncpus workers kept alive between frames
+    TileScheduler *m_scheduler; // tiles of the current frame, one deque per worker
+
+    // per worker state, allocated once and only rebuilt when ncpus or m_framePrecision change
+    worker_args *m_wargs;
+    int m_wargsCount;
+    int m_wargsPrecision;
+    unsigned long m_frameAllocations;
+    bool m_useArena;
+    bool m_useFixedPoint;
+    int m_fixedLimbs;
+    bool m_usePerturbation;
+    ReferenceOrbit *m_orbit; // reference of the last perturbation frame
+    bool m_reuseOrbit;
+    int m_referencePrecision;
+    bool m_orbitReused;
+    OrbitCache *m_orbitCache;   // NULL unless setOrbitCache was given a directory
+    bool m_orbitCached;
+    unsigned int m_orbitStored; // generation of m_orbit last written to the cache
+    OrbitStorage m_orbitStorage;
+    bool m_useSeries;
+    SeriesApproximation *m_series; // coefficients for the last perturbation frame
+    unsigned int m_frameSkip;
+    unsigned long long m_skippedIterations;
+    bool m_useBla;
+    size_t m_blaCap;
+    size_t m_blaBytes;
+    BlaTable<double> *m_bla;     // steps for TIER_PERTURBATION
+    BlaTable<floatexp> *m_blaFe; // steps for TIER_PERTURBATION_FLOATEXP
+    GlitchMode m_glitchMode;
+    unsigned int m_glitchedPixels;
+    unsigned int m_glitchReferences;
+    unsigned int m_unresolvedGlitches;
+    ReferenceOrbit *m_glitchOrbit;          // reference inside the glitched pixels
+    std::vector<unsigned int> m_glitchPixels; // glitched pixels, Dy*xsize + Dx
+    bool m_useBulbRejection;
+    unsigned int m_rejectedPixels;
+    unsigned int m_periodicTiers; // bit 1 << tier set where the cycle check is on
+    bool m_useSubdivision;
+    unsigned int m_filledPixels;
+    std::vector<unsigned int> m_counts; // every pixel's count while subdividing
 
     // mpfr vars
     mpfr_t Xe, Xs, Ye, Ys, Cx, Cy;       // algorithm values 
@@ -71,6 +289,18 @@ private:
 
     // methods
     void initialise_mpfr_vars();
+    void update_precision(const unsigned int xsize);
+    void grow_view_precision(const int bits);
+    NumericTier select_tier();
+    bool fixed_point_usable();
+    void compute_reference();
+    bool compress_orbits();
+    void gather_glitches();
+    void resolve_glitches(const unsigned int xsize, const unsigned int ysize);
+    void prepare_worker_state();
+    void free_worker_state();
     void push_sq_back_into_bounds();
     int cpuCount();
 };
+
+#endif /* MANDELBROT_MPFR_H */
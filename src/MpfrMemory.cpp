@@ -0,0 +1,144 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// MpfrMemory.cpp
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+
+#ifdef _WIN32
+#include <mpir.h> /* Was GMP */
+#else
+#include <gmp.h>
+#endif
+
+#include <mpfr.h>
+
+#include "MpfrMemory.h"
+
+#define ARENA_ALIGN 16
+
+static std::atomic<unsigned long> glb_allocations(0);
+static std::atomic<unsigned long> glb_arena_allocations(0);
+static std::once_flag glb_installed;
+
+static thread_local MpfrArena* tls_arena = NULL; // arena of the current worker, if any
+
+// CONSTRUCTORS --------------------------------------------------------------------------
+MpfrArena::MpfrArena(const size_t capacity)
+ : m_capacity(capacity),
+   m_used(0)
+{
+    m_buffer = (unsigned char*)malloc(m_capacity);
+    if (m_buffer == NULL) {
+        m_capacity = 0;
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+MpfrArena::~MpfrArena()
+{
+    free(m_buffer);
+}
+
+// PUBLIC METHODS ------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------
+// bump the offset, returns NULL when the block does not fit
+//
+void* MpfrArena::alloc(const size_t size)
+{
+    size_t rounded = (size + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1);
+    if (rounded > m_capacity - m_used) {
+        return NULL;
+    }
+    void* ptr = m_buffer + m_used;
+    m_used += rounded;
+    return ptr;
+}
+
+// ---------------------------------------------------------------------------------------
+bool MpfrArena::owns(const void* ptr)
+{
+    return ((const unsigned char*)ptr >= m_buffer) && ((const unsigned char*)ptr < m_buffer + m_capacity);
+}
+
+// ----------------------------------------------------------------------------
+// the counting versions of the GMP memory functions, plain libc underneath so
+// blocks allocated before install() can still be freed or grown by them.
+// inside an arena scope blocks come from the worker's arena first.
+//
+static void* counting_alloc(size_t size)
+{
+    if (tls_arena != NULL) {
+        void* ptr = tls_arena->alloc(size);
+        if (ptr != NULL) {
+            glb_arena_allocations.fetch_add(1, std::memory_order_relaxed);
+            return ptr;
+        }
+    }
+    glb_allocations.fetch_add(1, std::memory_order_relaxed);
+    return malloc(size);
+}
+
+static void* counting_realloc(void* ptr, size_t old_size, size_t new_size)
+{
+    if ((tls_arena != NULL) && tls_arena->owns(ptr)) {
+        // can't grow in place, move the block (to the arena if it still fits)
+        void* moved = counting_alloc(new_size);
+        memcpy(moved, ptr, (old_size < new_size) ? old_size : new_size);
+        return moved;
+    }
+    glb_allocations.fetch_add(1, std::memory_order_relaxed);
+    return realloc(ptr, new_size);
+}
+
+static void counting_free(void* ptr, size_t size)
+{
+    if ((tls_arena != NULL) && tls_arena->owns(ptr)) {
+        return; // released all at once by MpfrArena::reset()
+    }
+    free(ptr);
+}
+
+// PUBLIC METHODS ------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------
+void MpfrMemory::install()
+{
+    std::call_once(glb_installed, []{
+        mp_set_memory_functions(counting_alloc, counting_realloc, counting_free);
+    });
+}
+
+// ---------------------------------------------------------------------------------------
+unsigned long MpfrMemory::allocations()
+{
+    return glb_allocations.load(std::memory_order_relaxed);
+}
+
+// ---------------------------------------------------------------------------------------
+unsigned long MpfrMemory::arenaAllocations()
+{
+    return glb_arena_allocations.load(std::memory_order_relaxed);
+}
+
+// ---------------------------------------------------------------------------------------
+void MpfrMemory::enterArena(MpfrArena *arena)
+{
+    tls_arena = arena;
+}
+
+// ---------------------------------------------------------------------------------------
+// MPFR keeps a per thread pool of mpz_t whose limbs may have come from the arena,
+// empty it before the arena is reused
+//
+void MpfrMemory::leaveArena()
+{
+    if (tls_arena != NULL) {
+        mpfr_free_pool();
+        tls_arena->reset();
+        tls_arena = NULL;
+    }
+}
@@ -0,0 +1,59 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// MpfrMemory.h
+
+// memory functions handed to GMP (and so to MPFR) with mp_set_memory_functions.
+// every block GMP asks for is counted so a frame can show how many heap allocations
+// it made.  optionally a worker thread can switch to its own MpfrArena, a bump
+// allocator that is reset once per tile, so GMP/MPFR temporaries stop going through
+// (and contending in) the global malloc.
+
+#ifndef MPFR_MEMORY_H
+#define MPFR_MEMORY_H
+
+#include <stddef.h>
+
+#define MPFR_ARENA_SIZE (1 << 20) // bytes per worker
+
+// a bump allocator owned by one worker thread.  blocks are never freed one at a time,
+// the whole arena is emptied by reset().  requests that do not fit go to the heap.
+class MpfrArena
+{
+  public:
+    MpfrArena(const size_t capacity);
+    ~MpfrArena();
+
+    MpfrArena(MpfrArena &other) = delete;
+    void operator=(const MpfrArena&) = delete;
+
+    void* alloc(const size_t size);
+    bool owns(const void* ptr);
+    void reset() { m_used = 0; }
+
+    size_t used() { return m_used; }
+
+  private:
+    unsigned char *m_buffer;
+    size_t m_capacity;
+    size_t m_used;
+};
+
+class MpfrMemory
+{
+  public:
+    // route all GMP/MPFR allocations through the counting functions, safe to call
+    // more than once
+    static void install();
+
+    // number of heap allocations (malloc and realloc) made by GMP/MPFR since install()
+    static unsigned long allocations();
+
+    // number of blocks served from worker arenas since install()
+    static unsigned long arenaAllocations();
+
+    // serve the calling thread's GMP/MPFR allocations from arena until leaveArena().
+    // nothing allocated inside the scope may outlive it.
+    static void enterArena(MpfrArena *arena);
+    static void leaveArena();
+};
+
+#endif /* MPFR_MEMORY_H */
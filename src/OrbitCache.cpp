@@ -0,0 +1,163 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// OrbitCache.cpp
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+#include "OrbitCache.h"
+
+namespace fs = std::filesystem;
+
+#define ORBIT_FILE_EXTENSION ".orbit"
+
+// CONSTRUCTORS --------------------------------------------------------------------------
+OrbitCache::OrbitCache(const std::string &directory, const size_t capacity)
+ : m_directory(directory),
+   m_capacity(capacity),
+   m_hits(0),
+   m_misses(0)
+{
+    std::error_code ec;
+    fs::create_directories(m_directory, ec);
+}
+
+// PUBLIC METHODS ------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------
+// the file with the fewest bits that still has enough, a file that turns out not to be
+// of this centre (a hash collision) or not to be an orbit at all is passed over
+//
+bool OrbitCache::load(ReferenceOrbit *orbit, mpfr_srcptr cx, mpfr_srcptr cy, const int precision)
+{
+    const std::string start = prefix(ReferenceOrbit::centreKey(cx, cy));
+    std::vector<std::pair<int, fs::path> > candidates;
+    std::error_code ec;
+    for (fs::directory_iterator it(m_directory, ec), end; !ec && (it != end); it.increment(ec))
+    {
+        const std::string name = it->path().filename().string();
+        if ((name.compare(0, start.size(), start) == 0) && (it->path().extension() == ORBIT_FILE_EXTENSION)) {
+            int bits = atoi(name.c_str() + start.size());
+            if (bits >= precision) {
+                candidates.push_back(std::make_pair(bits, it->path()));
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        if (orbit->load(candidates[i].second.string().c_str(), cx, cy)) {
+            std::error_code touch_ec;
+            fs::last_write_time(candidates[i].second, fs::file_time_type::clock::now(), touch_ec);
+            m_hits++;
+            return true;
+        }
+    }
+    m_misses++;
+    return false;
+}
+
+// ---------------------------------------------------------------------------------------
+// written to a temporary name and renamed, so another run never loads half a file
+//
+bool OrbitCache::store(ReferenceOrbit *orbit)
+{
+    const std::string key = orbit->key();
+    if (key.empty()) {
+        return false;
+    }
+    const std::string name = prefix(key) + std::to_string(orbit->precision()) + ORBIT_FILE_EXTENSION;
+    const fs::path path = fs::path(m_directory) / name;
+    const fs::path tmp = fs::path(m_directory) / (name + ".tmp");
+
+    std::error_code ec;
+    if (!orbit->save(tmp.string().c_str())) {
+        fs::remove(tmp, ec);
+        return false;
+    }
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        return false;
+    }
+    evict(name);
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------
+size_t OrbitCache::bytes()
+{
+    size_t total = 0;
+    std::error_code ec;
+    for (fs::directory_iterator it(m_directory, ec), end; !ec && (it != end); it.increment(ec))
+    {
+        if (it->path().extension() == ORBIT_FILE_EXTENSION) {
+            std::error_code size_ec;
+            size_t size = (size_t)it->file_size(size_ec);
+            total += size_ec ? 0 : size;
+        }
+    }
+    return total;
+}
+
+// PRIVATE METHODS -----------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------
+// FNV-1a of the centre, the start of the name of every file of that centre
+//
+std::string OrbitCache::prefix(const std::string &key)
+{
+    unsigned long long hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < key.size(); i++)
+    {
+        hash ^= (unsigned char)key[i];
+        hash *= 1099511628211ULL;
+    }
+    char str[32];
+    snprintf(str, sizeof(str), "%016llx-", hash);
+    return std::string(str);
+}
+
+// ---------------------------------------------------------------------------------------
+// remove the oldest orbit files until the rest fit in m_capacity, the one just written
+// (keep) stays even if it doesn't fit on its own
+//
+void OrbitCache::evict(const std::string &keep)
+{
+    struct Entry { fs::file_time_type time; size_t size; fs::path path; };
+    std::vector<Entry> entries;
+    size_t total = 0;
+    std::error_code ec;
+    for (fs::directory_iterator it(m_directory, ec), end; !ec && (it != end); it.increment(ec))
+    {
+        if (it->path().extension() != ORBIT_FILE_EXTENSION) {
+            continue;
+        }
+        Entry entry;
+        std::error_code entry_ec;
+        entry.size = (size_t)it->file_size(entry_ec);
+        entry.time = it->last_write_time(entry_ec);
+        entry.path = it->path();
+        if (entry_ec) {
+            continue; // gone since the directory was listed
+        }
+        total += entry.size;
+        if (entry.path.filename() != keep) {
+            entries.push_back(entry);
+        }
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry &a, const Entry &b) { return a.time < b.time; });
+
+    for (size_t i = 0; (i < entries.size()) && (total > m_capacity); i++)
+    {
+        std::error_code remove_ec;
+        if (fs::remove(entries[i].path, remove_ec)) {
+            total -= entries[i].size;
+        }
+    }
+}
@@ -0,0 +1,56 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// OrbitCache.h
+
+// reference orbits kept on disk between runs, so re-rendering a deep zoom with another
+// palette, size or frame range loads its orbit instead of iterating it again at full
+// precision.  a file holds one orbit and is named after its centre and precision,
+// "<hash of centre>-<bits>.orbit"; the centre itself is checked on load.  any orbit
+// of the centre with at least the bits asked for will do, and one with too few
+// iterations is loaded and extended.
+//
+// the files are evicted least recently used first (by modification time, which a
+// load bumps) to keep the directory under capacity bytes.
+
+#ifndef ORBIT_CACHE_H
+#define ORBIT_CACHE_H
+
+#include <string>
+#include <mpfr.h>
+#include "ReferenceOrbit.h"
+
+#define ORBIT_CACHE_DEFAULT_CAPACITY (1024 * 1024 * 1024) // bytes
+
+class OrbitCache
+{
+  public:
+    OrbitCache(const std::string &directory, const size_t capacity);
+    ~OrbitCache() {}
+
+    OrbitCache(OrbitCache &other) = delete;
+    void operator=(const OrbitCache&) = delete;
+
+    // read the orbit of cx + i*cy with at least precision bits into orbit, false if
+    // there is none
+    bool load(ReferenceOrbit *orbit, mpfr_srcptr cx, mpfr_srcptr cy, const int precision);
+    // write orbit (replacing any file of the same centre and precision), then evict
+    // down to capacity.  false if it couldn't be written, the cache is only a cache.
+    bool store(ReferenceOrbit *orbit);
+
+    const std::string& directory() { return m_directory; }
+    size_t capacity() { return m_capacity; }
+    // bytes of orbit files in the directory
+    size_t bytes();
+    unsigned int hits() { return m_hits; }
+    unsigned int misses() { return m_misses; }
+
+  private:
+    std::string prefix(const std::string &key);
+    void evict(const std::string &keep);
+
+    std::string m_directory;
+    size_t m_capacity;
+    unsigned int m_hits;
+    unsigned int m_misses;
+};
+
+#endif /* ORBIT_CACHE_H */
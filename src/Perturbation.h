@@ -0,0 +1,147 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// Perturbation.h
+
+// perturbation theory escape time kernel.  with Z_n the reference orbit at C and
+// z_n = Z_n + d_n the orbit of a pixel at c = C + dc,
+//
+//     d_n+1 = 2*Z_n*d_n + d_n^2 + dc
+//
+// d and dc are tiny, but their relative precision is all a pixel needs, so they can
+// be held in a double (or a floatexp once they would underflow one) however deep the
+// zoom while only the reference orbit is iterated in mpfr.  z itself is back near the
+// size of Z, so the bailout is always tested in double.
+
+#ifndef PERTURBATION_H
+#define PERTURBATION_H
+
+#include "BlaTable.h"
+#include "ReferenceOrbit.h"
+
+#define GLITCH_TOLERANCE 1e-6 // |z|^2 against |Z|^2 for Pauldelbrot's test
+
+// what the kernel does about a pixel whose orbit has lost the reference, where z
+// passes close to 0 while Z doesn't and d has no bits left to say where it went.
+// GLITCH_REBASE carries on from the start of the orbit with d = z as soon as |z| < |d|,
+// GLITCH_REFERENCES stops the pixel at |z|^2 < GLITCH_TOLERANCE*|Z|^2 (Pauldelbrot's
+// test) so it can be done again against a reference nearer to it
+enum GlitchMode { GLITCH_NONE, GLITCH_REBASE, GLITCH_REFERENCES };
+
+/* ----------------------------------------------------------------------------
+ * calculate_point_perturbed
+ * calculate_point for the pixel dcx + i*dcy away from the reference orbit,
+ * read through a cursor (OrbitArrayCursor or OrbitWaypointCursor) that steps
+ * along it with the pixel.  the count follows the bailout of calculate_point.
+ *
+ * the first skip iterations can be jumped, starting from d_skip = d0x + i*d0y
+ * (from the series approximation), every pixel is known to get that far.
+ *
+ * with a BLA table, wherever one of its steps holds for the current d the
+ * pixel jumps by that many iterations in one go.
+ *
+ * when the pixel outlives the reference (the last stored Z is reached) the
+ * delta is rebased onto the start of the orbit, d = z and n = 0, which is
+ * exact since Z_0 = 0.
+ *
+ * glitch says what to do when the pixel loses the reference, glitched is set
+ * if it did (rebased under GLITCH_REBASE, or stopped early and its count not
+ * to be trusted under GLITCH_REFERENCES).
+ *
+ * Params
+ * orbit (Orbit&) cursor over the reference orbit, at least 2 points
+ * dcx, dcy (T) offset of the pixel from the reference
+ * maxiter (int) the escape value
+ * skip (int) iteration to start at, less than the orbit length - 1
+ * d0x, d0y (T) delta at iteration skip
+ * bla (BlaTable*) steps along the orbit, or NULL
+ * glitch (GlitchMode) detection and correction of glitches
+ * (out) glitched (bool*) true if the pixel lost the reference
+ *
+ * Returns
+ * iteration - count of how many iterations it took to head to infinity
+ */
+template<typename T, typename Orbit>
+inline unsigned int calculate_point_perturbed(
+                        Orbit &orbit,
+                        const T dcx, 
+                        const T dcy, 
+                        const unsigned int maxiter,
+                        const unsigned int skip,
+                        const T d0x,
+                        const T d0y,
+                        const BlaTable<T> *bla,
+                        const GlitchMode glitch,
+                        bool *glitched)
+{
+    T dx = d0x;
+    T dy = d0y;
+    T dxtemp = T(0);
+    double zx = 0.0;
+    double zy = 0.0;
+    double sum = 0.0;
+    const unsigned int length = orbit.length();
+    unsigned int n = skip;
+    unsigned int iteration = skip;
+    orbit.seek(n);
+
+    while ((sum <= 4.0) && iteration < maxiter)
+    {
+        if (n == length - 1) {
+            dx = T(orbit.re() + (double)dx);
+            dy = T(orbit.im() + (double)dy);
+            n = 0;
+            orbit.seek(n);
+        }
+        if (bla != NULL) {
+            unsigned int steps = 0;
+            const BlaStep<T> *step = bla->lookup(n, dx*dx + dy*dy, maxiter - iteration, &steps);
+            if (step != NULL) {
+                // d = A*d + B*dc
+                dxtemp = (step->ar*dx - step->ai*dy) + (step->br*dcx - step->bi*dcy);
+                dy = (step->ar*dy + step->ai*dx) + (step->br*dcy + step->bi*dcx);
+                dx = dxtemp;
+                n += steps;
+                iteration += steps;
+                orbit.seek(n);
+                continue;
+            }
+        }
+        const double Zr = orbit.re();
+        const double Zi = orbit.im();
+        T Zx = T(Zr);
+        T Zy = T(Zi);
+        const double ddx = (double)dx;
+        const double ddy = (double)dy;
+        zx = Zr + ddx;
+        zy = Zi + ddy;
+        sum = zx*zx + zy*zy;
+
+        if (glitch == GLITCH_REBASE) {
+            // z is nearer 0 than Z is, carry on from Z_0 = 0 with d = z
+            if (sum < ddx*ddx + ddy*ddy) {
+                dx = Zx + dx;
+                dy = Zy + dy;
+                Zx = T(0);
+                Zy = T(0);
+                n = 0;
+                orbit.seek(n);
+                *glitched = true;
+            }
+        } else if (glitch == GLITCH_REFERENCES) {
+            if (sum < GLITCH_TOLERANCE * (Zr*Zr + Zi*Zi)) {
+                *glitched = true;
+                return iteration;
+            }
+        }
+
+        // d = 2*Z*d + d^2 + dc
+        dxtemp = T(2)*(Zx*dx - Zy*dy) + (dx*dx - dy*dy) + dcx;
+        dy = T(2)*(Zx*dy + Zy*dx) + T(2)*dx*dy + dcy;
+        dx = dxtemp;
+        n++;
+        iteration++;
+        orbit.next();
+    }
+    return iteration;
+}
+
+#endif /* PERTURBATION_H */
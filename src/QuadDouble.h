@@ -0,0 +1,187 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// QuadDouble.h
+
+// qdouble - an unevaluated sum of four doubles, x[0] + x[1] + x[2] + x[3], each no
+// more than half an ulp of the one before, about 212 bits of mantissa.  built from
+// the same error free transforms as ddouble (DoubleDouble.h) and plugged into the
+// kernels the same way, calculate_point<qdouble>, for pixel spacings down to about
+// 1e-60.
+//
+// the add and multiply are the QD library's "sloppy" ones: under cancellation the
+// error is relative to the larger operand rather than the result, which is all the
+// escape time loop needs since every z is compared against a fixed bailout.
+
+#ifndef QUAD_DOUBLE_H
+#define QUAD_DOUBLE_H
+
+#include "DoubleDouble.h"
+
+#define QDOUBLE_MANT_DIG 212
+
+// ----------------------------------------------------------------------------
+// (a, b, c) -> (a, b) with a + b + c kept to the last bit of b and the rest in c
+//
+inline void three_sum(double &a, double &b, double &c)
+{
+    double t1, t2, t3;
+    t1 = two_sum(a, b, t2);
+    a = two_sum(c, t1, t3);
+    b = two_sum(t2, t3, c);
+}
+
+// the same when the error below b isn't wanted
+inline void three_sum2(double &a, double &b, const double c)
+{
+    double t1, t2, t3;
+    t1 = two_sum(a, b, t2);
+    a = two_sum(c, t1, t3);
+    b = t2 + t3;
+}
+
+// ----------------------------------------------------------------------------
+// renorm - five overlapping doubles, largest first, back to four that don't
+// overlap, a zero along the way moves the rest up
+//
+inline void renorm(double &c0, double &c1, double &c2, double &c3, double c4)
+{
+    double s0, s1, s2 = 0.0, s3 = 0.0;
+
+    s0 = quick_two_sum(c3, c4, c4);
+    s0 = quick_two_sum(c2, s0, c3);
+    s0 = quick_two_sum(c1, s0, c2);
+    c0 = quick_two_sum(c0, s0, c1);
+
+    s0 = quick_two_sum(c0, c1, s1);
+    if (s1 != 0.0) {
+        s1 = quick_two_sum(s1, c2, s2);
+        if (s2 != 0.0) {
+            s2 = quick_two_sum(s2, c3, s3);
+            if (s3 != 0.0) {
+                s3 += c4;
+            } else {
+                s2 = quick_two_sum(s2, c4, s3);
+            }
+        } else {
+            s1 = quick_two_sum(s1, c3, s2);
+            if (s2 != 0.0) {
+                s2 = quick_two_sum(s2, c4, s3);
+            } else {
+                s1 = quick_two_sum(s1, c4, s2);
+            }
+        }
+    } else {
+        s0 = quick_two_sum(s0, c2, s1);
+        if (s1 != 0.0) {
+            s1 = quick_two_sum(s1, c3, s2);
+            if (s2 != 0.0) {
+                s2 = quick_two_sum(s2, c4, s3);
+            } else {
+                s1 = quick_two_sum(s1, c4, s2);
+            }
+        } else {
+            s0 = quick_two_sum(s0, c3, s1);
+            if (s1 != 0.0) {
+                s1 = quick_two_sum(s1, c4, s2);
+            } else {
+                s0 = quick_two_sum(s0, c4, s1);
+            }
+        }
+    }
+    c0 = s0; c1 = s1; c2 = s2; c3 = s3;
+}
+
+class qdouble
+{
+  public:
+    qdouble() { x[0] = x[1] = x[2] = x[3] = 0.0; }
+    qdouble(const double v) { x[0] = v; x[1] = x[2] = x[3] = 0.0; }
+    qdouble(const int v) { x[0] = (double)v; x[1] = x[2] = x[3] = 0.0; }
+    // the sum of four doubles, largest first, not necessarily normalised
+    qdouble(const double a, const double b, const double c, const double d)
+    {
+        x[0] = a; x[1] = b; x[2] = c; x[3] = d;
+        renorm(x[0], x[1], x[2], x[3], 0.0);
+    }
+
+    explicit operator double() const { return x[0]; }
+    double operator[](const int i) const { return x[i]; }
+
+    qdouble operator-() const { qdouble r; for (int i = 0; i < 4; i++) { r.x[i] = -x[i]; } return r; }
+
+    friend qdouble operator+(const qdouble &a, const qdouble &b)
+    {
+        // component by component, then the four errors folded into the sum
+        double s0, s1, s2, s3;
+        double t0, t1, t2, t3;
+
+        s0 = two_sum(a.x[0], b.x[0], t0);
+        s1 = two_sum(a.x[1], b.x[1], t1);
+        s2 = two_sum(a.x[2], b.x[2], t2);
+        s3 = two_sum(a.x[3], b.x[3], t3);
+
+        s1 = two_sum(s1, t0, t0);
+        three_sum(s2, t0, t1);
+        three_sum2(s3, t0, t2);
+        t0 = t0 + t1 + t3;
+
+        qdouble r;
+        renorm(s0, s1, s2, s3, t0);
+        r.x[0] = s0; r.x[1] = s1; r.x[2] = s2; r.x[3] = s3;
+        return r;
+    }
+
+    friend qdouble operator-(const qdouble &a, const qdouble &b) { return a + (-b); }
+
+    friend qdouble operator*(const qdouble &a, const qdouble &b)
+    {
+        // the products of order 1, eps and eps^2 exactly, eps^3 in plain doubles
+        // and nothing below
+        double p0, p1, p2, p3, p4, p5;
+        double q0, q1, q2, q3, q4, q5;
+        double s0, s1, s2, t0, t1;
+
+        p0 = two_prod(a.x[0], b.x[0], q0);
+
+        p1 = two_prod(a.x[0], b.x[1], q1);
+        p2 = two_prod(a.x[1], b.x[0], q2);
+
+        p3 = two_prod(a.x[0], b.x[2], q3);
+        p4 = two_prod(a.x[1], b.x[1], q4);
+        p5 = two_prod(a.x[2], b.x[0], q5);
+
+        three_sum(p1, p2, q0);
+
+        // (p2, q1, q2) + (p3, p4, p5)
+        three_sum(p2, q1, q2);
+        three_sum(p3, p4, p5);
+        s0 = two_sum(p2, p3, t0);
+        s1 = two_sum(q1, p4, t1);
+        s2 = q2 + p5;
+        s1 = two_sum(s1, t0, t0);
+        s2 += (t0 + t1);
+
+        s1 += a.x[0] * b.x[3] + a.x[1] * b.x[2] + a.x[2] * b.x[1] + a.x[3] * b.x[0] + q0 + q3 + q4 + q5;
+
+        qdouble r;
+        renorm(p0, p1, s0, s1, s2);
+        r.x[0] = p0; r.x[1] = p1; r.x[2] = s0; r.x[3] = s1;
+        return r;
+    }
+
+    friend bool operator<=(const qdouble &a, const qdouble &b)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            if (a.x[i] != b.x[i]) {
+                return a.x[i] < b.x[i];
+            }
+        }
+        return a.x[3] <= b.x[3];
+    }
+    friend bool operator<(const qdouble &a, const qdouble &b) { return !(b <= a); }
+
+  private:
+    double x[4];
+};
+
+#endif /* QUAD_DOUBLE_H */
@@ -0,0 +1,436 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// ReferenceOrbit.cpp
+
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "ReferenceOrbit.h"
+
+#define ORBIT_FILE_MAGIC "MBORBIT1"
+
+// an orbit file is the header, the key and state strings padded to 8 bytes, then
+// length doubles of re and length of im.  a compressed orbit has instead the
+// waypoints as n (padded to 8 bytes), re and im, the last point, then the
+// corrections (padded to 8 bytes).
+struct OrbitFileHeader
+{
+    char magic[8];
+    uint32_t precision;
+    uint32_t length;
+    uint32_t escaped;
+    uint32_t keyBytes;   // centreKey() of the orbit
+    uint32_t stateBytes; // the last point, "x,y" as hex floats at full precision
+    uint32_t waypoints;  // 0 unless compressed
+};
+
+static size_t pad8(const size_t n) { return (n + 7) & ~(size_t)7; }
+
+// CONSTRUCTORS --------------------------------------------------------------------------
+ReferenceOrbit::ReferenceOrbit()
+ : m_precision(0),
+   m_compressed(false),
+   m_cxd(0.0), m_cyd(0.0),
+   m_tailx(0.0), m_taily(0.0),
+   m_length(0),
+   m_escaped(false),
+   m_generation(0)
+{
+    mpfr_inits2(MPFR_PREC_MIN, m_keyx, m_keyy, (mpfr_ptr)NULL);
+    mpfr_set_nan(m_keyx);
+    mpfr_set_nan(m_keyy);
+}
+
+// ---------------------------------------------------------------------------------------
+ReferenceOrbit::~ReferenceOrbit()
+{
+    set_precision(0);
+    mpfr_clears(m_keyx, m_keyy, (mpfr_ptr)NULL);
+}
+
+// PUBLIC METHODS ------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------
+// the same loop (and rounding) as the mpfr tier's mpfr_escape, one point only so it
+// runs on the calling thread before the workers start
+//
+void ReferenceOrbit::compute(mpfr_srcptr cx, mpfr_srcptr cy, const int precision, const unsigned int maxiter)
+{
+    set_precision(precision);
+    reserve(maxiter);
+    set_key(cx, cy);
+
+    mpfr_set(m_cx, cx, MPFR_RNDN);
+    mpfr_set(m_cy, cy, MPFR_RNDN);
+    mpfr_set_d(m_x, 0.0, MPFR_RNDN);
+    mpfr_set_d(m_y, 0.0, MPFR_RNDN);
+    m_cxd = mpfr_get_d(m_cx, MPFR_RNDN);
+    m_cyd = mpfr_get_d(m_cy, MPFR_RNDN);
+    if (m_compressed) {
+        OrbitWaypoint start = { 0, 0.0, 0.0 };
+        m_waypoints.clear();
+        m_waypoints.push_back(start);
+        m_corrections.assign(2, 0);
+        m_tailx = 0.0;
+        m_taily = 0.0;
+    } else {
+        m_re[0] = 0.0;
+        m_im[0] = 0.0;
+    }
+    m_length = 1;
+    m_escaped = false;
+    iterate(maxiter);
+}
+
+// ---------------------------------------------------------------------------------------
+void ReferenceOrbit::extend(const unsigned int maxiter)
+{
+    if (m_escaped || (m_length == 0) || (m_length > maxiter)) {
+        return;
+    }
+    reserve(maxiter);
+    iterate(maxiter);
+}
+
+// ---------------------------------------------------------------------------------------
+bool ReferenceOrbit::sameCentre(mpfr_srcptr cx, mpfr_srcptr cy)
+{
+    return mpfr_equal_p(m_keyx, cx) && mpfr_equal_p(m_keyy, cy);
+}
+
+// ---------------------------------------------------------------------------------------
+bool ReferenceOrbit::matches(mpfr_srcptr cx, mpfr_srcptr cy, const int precision)
+{
+    return (m_length > 0) && (m_precision >= precision) && sameCentre(cx, cy);
+}
+
+// ---------------------------------------------------------------------------------------
+bool ReferenceOrbit::save(const char *path)
+{
+    if (m_length == 0) {
+        return false;
+    }
+    std::string key = this->key();
+    char *state = NULL;
+    if (mpfr_asprintf(&state, "%Ra,%Ra", m_x, m_y) < 0) {
+        return false;
+    }
+    OrbitFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ORBIT_FILE_MAGIC, sizeof(header.magic));
+    header.precision = (uint32_t)m_precision;
+    header.length = m_length;
+    header.escaped = m_escaped ? 1 : 0;
+    header.keyBytes = (uint32_t)key.size();
+    header.stateBytes = (uint32_t)strlen(state);
+    header.waypoints = m_compressed ? (uint32_t)m_waypoints.size() : 0;
+
+    std::string strings = key + state;
+    strings.resize(pad8(strings.size()), '\0');
+    mpfr_free_str(state);
+
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL) {
+        return false;
+    }
+    bool ok = (fwrite(&header, sizeof(header), 1, fp) == 1) &&
+              (fwrite(strings.data(), 1, strings.size(), fp) == strings.size());
+    if (m_compressed) {
+        const size_t count = m_waypoints.size();
+        std::vector<uint32_t> n(pad8(count * sizeof(uint32_t)) / sizeof(uint32_t), 0);
+        std::vector<double> re(count), im(count);
+        for (size_t w = 0; w < count; w++)
+        {
+            n[w] = m_waypoints[w].n;
+            re[w] = m_waypoints[w].re;
+            im[w] = m_waypoints[w].im;
+        }
+        const double tail[2] = { m_tailx, m_taily };
+        std::vector<int8_t> corrections(m_corrections);
+        corrections.resize(pad8(corrections.size()), 0);
+        ok = ok && (fwrite(n.data(), sizeof(uint32_t), n.size(), fp) == n.size()) &&
+                   (fwrite(re.data(), sizeof(double), count, fp) == count) &&
+                   (fwrite(im.data(), sizeof(double), count, fp) == count) &&
+                   (fwrite(tail, sizeof(double), 2, fp) == 2) &&
+                   (fwrite(corrections.data(), 1, corrections.size(), fp) == corrections.size());
+    } else {
+        ok = ok && (fwrite(m_re.data(), sizeof(double), m_length, fp) == m_length) &&
+                   (fwrite(m_im.data(), sizeof(double), m_length, fp) == m_length);
+    }
+    return (fclose(fp) == 0) && ok;
+}
+
+// ---------------------------------------------------------------------------------------
+// the points are copied out of the mapping, they are rewritten as soon as the orbit
+// is extended
+//
+bool ReferenceOrbit::load(const char *path, mpfr_srcptr cx, mpfr_srcptr cy)
+{
+    const unsigned char *data = NULL;
+    size_t size = 0;
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    void *map = MAP_FAILED;
+    if ((fstat(fd, &st) == 0) && (st.st_size > 0)) {
+        size = (size_t)st.st_size;
+        map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    data = (const unsigned char*)map;
+#else
+    std::vector<unsigned char> buffer;
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    unsigned char chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+        buffer.insert(buffer.end(), chunk, chunk + n);
+    }
+    fclose(fp);
+    data = buffer.data();
+    size = buffer.size();
+#endif
+
+    bool ok = false;
+    OrbitFileHeader header;
+    if (size >= sizeof(header)) {
+        memcpy(&header, data, sizeof(header));
+        size_t strings = pad8((size_t)header.keyBytes + header.stateBytes);
+        size_t points = m_compressed ? pad8(sizeof(uint32_t) * (size_t)header.waypoints) + 
+                                       2 * sizeof(double) * ((size_t)header.waypoints + 1) +
+                                       pad8(2 * (size_t)header.length)
+                                     : 2 * sizeof(double) * (size_t)header.length;
+        ok = (memcmp(header.magic, ORBIT_FILE_MAGIC, sizeof(header.magic)) == 0) &&
+             (header.precision >= MPFR_PREC_MIN) && (header.length > 0) &&
+             (m_compressed == (header.waypoints > 0)) &&
+             (size == sizeof(header) + strings + points);
+    }
+    if (ok) {
+        const char *key = (const char*)data + sizeof(header);
+        ok = (centreKey(cx, cy) == std::string(key, header.keyBytes));
+    }
+    if (ok) {
+        // the last point first, the orbit is left as it was if it doesn't parse
+        std::string state((const char*)data + sizeof(header) + header.keyBytes, header.stateBytes);
+        mpfr_t x, y;
+        mpfr_inits2((mpfr_prec_t)header.precision, x, y, (mpfr_ptr)NULL);
+        char *end = NULL;
+        ok = (mpfr_strtofr(x, state.c_str(), &end, 0, MPFR_RNDN) == 0) && (*end == ',') &&
+             (mpfr_strtofr(y, end + 1, &end, 0, MPFR_RNDN) == 0) && (*end == '\0');
+        if (ok) {
+            set_precision((int)header.precision);
+            mpfr_set(m_x, x, MPFR_RNDN);
+            mpfr_set(m_y, y, MPFR_RNDN);
+        }
+        mpfr_clears(x, y, (mpfr_ptr)NULL);
+    }
+    if (ok) {
+        const unsigned char *points = data + sizeof(header) + pad8((size_t)header.keyBytes + header.stateBytes);
+        m_length = header.length;
+        m_escaped = (header.escaped != 0);
+        if (m_compressed) {
+            const size_t count = header.waypoints;
+            const uint32_t *n = (const uint32_t*)points;
+            const double *re = (const double*)(points + pad8(sizeof(uint32_t) * count));
+            m_waypoints.resize(count);
+            for (size_t w = 0; w < count; w++)
+            {
+                m_waypoints[w].n = n[w];
+                m_waypoints[w].re = re[w];
+                m_waypoints[w].im = re[count + w];
+            }
+            m_tailx = re[2 * count];
+            m_taily = re[2 * count + 1];
+            const int8_t *corrections = (const int8_t*)(re + 2 * count + 2);
+            m_corrections.assign(corrections, corrections + 2 * (size_t)m_length);
+        } else {
+            const double *re = (const double*)points;
+            reserve(m_length - 1);
+            memcpy(m_re.data(), re, sizeof(double) * m_length);
+            memcpy(m_im.data(), re + m_length, sizeof(double) * m_length);
+        }
+        set_key(cx, cy);
+        mpfr_set(m_cx, cx, MPFR_RNDN);
+        mpfr_set(m_cy, cy, MPFR_RNDN);
+        m_cxd = mpfr_get_d(m_cx, MPFR_RNDN);
+        m_cyd = mpfr_get_d(m_cy, MPFR_RNDN);
+        m_generation++;
+    }
+#ifndef _WIN32
+    munmap((void*)data, size);
+#endif
+    return ok;
+}
+
+// ---------------------------------------------------------------------------------------
+void ReferenceOrbit::setCompressed(const bool compressed)
+{
+    if (compressed != m_compressed) {
+        m_compressed = compressed;
+        clear_points();
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+size_t ReferenceOrbit::bytes()
+{
+    return (m_re.capacity() + m_im.capacity()) * sizeof(double) + 
+           m_waypoints.capacity() * sizeof(OrbitWaypoint) + m_corrections.capacity();
+}
+
+// ---------------------------------------------------------------------------------------
+std::string ReferenceOrbit::centreKey(mpfr_srcptr cx, mpfr_srcptr cy)
+{
+    char *str = NULL;
+    if (mpfr_asprintf(&str, "%Ra,%Ra", cx, cy) < 0) {
+        return std::string();
+    }
+    std::string key(str);
+    mpfr_free_str(str);
+    return key;
+}
+
+// ---------------------------------------------------------------------------------------
+std::string ReferenceOrbit::key()
+{
+    return (m_length > 0) ? centreKey(m_keyx, m_keyy) : std::string();
+}
+
+// PRIVATE METHODS -----------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------
+// room for Z_0 .. Z_maxiter, never shrinks.  a compressed orbit has room for the
+// corrections of them all, its waypoints grow as it goes
+//
+void ReferenceOrbit::reserve(const unsigned int maxiter)
+{
+    if (m_compressed) {
+        m_corrections.reserve(2 * ((size_t)maxiter + 1));
+    } else if (m_re.size() < (size_t)maxiter + 1) {
+        m_re.resize((size_t)maxiter + 1);
+        m_im.resize((size_t)maxiter + 1);
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// carry on from the last point (in m_x, m_y) up to Z_maxiter or the escape.  the
+// cross term is worked out as mpfr_escape does at this precision, as 2*x*y or from
+// MPFR_SQUARE_CROSS_BITS as (x+y)^2 - (xsq + ysq), so Z rounds the same way
+//
+void ReferenceOrbit::iterate(const unsigned int maxiter)
+{
+    const bool square_cross = (m_precision >= MPFR_SQUARE_CROSS_BITS);
+
+    m_generation++;
+
+    while (m_length <= maxiter)
+    {
+        mpfr_sqr(m_xsq, m_x, MPFR_RNDN);           // xsq = x*x
+        mpfr_sqr(m_ysq, m_y, MPFR_RNDN);           // ysq = y*y
+        if (square_cross) {
+            mpfr_add(m_tmp, m_xsq, m_ysq, MPFR_RNDN);
+            mpfr_add(m_y, m_y, m_x, MPFR_RNDN);    // y = (x+y)^2 - (xsq + ysq) + cy
+            mpfr_sqr(m_y, m_y, MPFR_RNDN);
+            mpfr_sub(m_y, m_y, m_tmp, MPFR_RNDN);
+        } else {
+            mpfr_mul(m_y, m_y, m_x, MPFR_RNDN);    // y = 2*x*y + cy
+            mpfr_mul_2ui(m_y, m_y, 1, MPFR_RNDN);
+        }
+        mpfr_add(m_y, m_y, m_cy, MPFR_RNDN);
+        mpfr_sub(m_x, m_xsq, m_ysq, MPFR_RNDN);    // x = xsq - ysq + cx
+        mpfr_add(m_x, m_x, m_cx, MPFR_RNDN);
+
+        const double re = mpfr_get_d(m_x, MPFR_RNDN);
+        const double im = mpfr_get_d(m_y, MPFR_RNDN);
+        if (m_compressed) {
+            // the step from the last point as the cursors will take it, and how many
+            // doubles out it is (wrapping, a difference that big is a waypoint anyway).
+            // a waypoint if that's too many to store, or the last waypoint is too far back
+            orbit_step(m_cxd, m_cyd, &m_tailx, &m_taily);
+            const int64_t ex = (int64_t)((uint64_t)orbit_ulps(re) - (uint64_t)orbit_ulps(m_tailx));
+            const int64_t ey = (int64_t)((uint64_t)orbit_ulps(im) - (uint64_t)orbit_ulps(m_taily));
+            if ((m_length - m_waypoints.back().n >= ORBIT_WAYPOINT_SPACING) ||
+                (ex < -ORBIT_CORRECTION_MAX) || (ex > ORBIT_CORRECTION_MAX) ||
+                (ey < -ORBIT_CORRECTION_MAX) || (ey > ORBIT_CORRECTION_MAX)) {
+                OrbitWaypoint waypoint = { m_length, re, im };
+                m_waypoints.push_back(waypoint);
+                m_corrections.push_back(0);
+                m_corrections.push_back(0);
+            } else {
+                m_corrections.push_back((int8_t)ex);
+                m_corrections.push_back((int8_t)ey);
+            }
+            m_tailx = re;
+            m_taily = im;
+        } else {
+            m_re[m_length] = re;
+            m_im[m_length] = im;
+        }
+        m_length++;
+
+        if ((re * re + im * im) > 4.0) {
+            m_escaped = true;
+            break;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// the centre as given, kept at its own precision so sameCentre() is exact
+//
+void ReferenceOrbit::set_key(mpfr_srcptr cx, mpfr_srcptr cy)
+{
+    if ((mpfr_get_prec(m_keyx) != mpfr_get_prec(cx)) || (mpfr_get_prec(m_keyy) != mpfr_get_prec(cy))) {
+        mpfr_set_prec(m_keyx, mpfr_get_prec(cx));
+        mpfr_set_prec(m_keyy, mpfr_get_prec(cy));
+    }
+    mpfr_set(m_keyx, cx, MPFR_RNDN);
+    mpfr_set(m_keyy, cy, MPFR_RNDN);
+}
+
+// ---------------------------------------------------------------------------------------
+// forget the orbit, and the memory its points held
+//
+void ReferenceOrbit::clear_points()
+{
+    std::vector<double>().swap(m_re);
+    std::vector<double>().swap(m_im);
+    std::vector<OrbitWaypoint>().swap(m_waypoints);
+    std::vector<int8_t>().swap(m_corrections);
+    m_length = 0;
+    m_escaped = false;
+    m_generation++;
+}
+
+// ---------------------------------------------------------------------------------------
+// (re)initialise the mpfr vars at precision bits, 0 just clears them
+//
+void ReferenceOrbit::set_precision(const int precision)
+{
+    if (precision == m_precision) {
+        return;
+    }
+    if (m_precision != 0) {
+        mpfr_clears(m_cx, m_cy, m_x, m_y, m_xsq, m_ysq, m_tmp, (mpfr_ptr)NULL);
+    }
+    m_precision = precision;
+    if (m_precision != 0) {
+        mpfr_inits2(m_precision, m_cx, m_cy, m_x, m_y, m_xsq, m_ysq, m_tmp, (mpfr_ptr)NULL);
+    }
+}
@@ -0,0 +1,234 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// ReferenceOrbit.h
+
+// the orbit of one point, iterated at full mpfr precision and kept as doubles, for
+// the perturbation engine.  every pixel near the reference only iterates its small
+// difference from this orbit, see Perturbation.h.
+//
+// an orbit can serve a whole zoom sequence into a fixed point, matches() says whether
+// it is good for a frame and extend() carries it on if the frame wants more iterations.
+// save() and load() keep it in a file, with the last point at full precision so a
+// loaded orbit can still be extended, see OrbitCache.h.
+//
+// a compressed orbit keeps waypoints and a correction per point.  between waypoints
+// Z is regenerated in double, Z_n+1 = Z_n^2 + C, and each step is put right by the
+// number of doubles (ulps) it landed away from the true point rounded to double, one
+// signed byte each for re and im.  so every regenerated point is exactly the one a
+// full orbit stores.  a waypoint is stored where a correction doesn't fit in a byte
+// (under cancellation) and at least every ORBIT_WAYPOINT_SPACING points so a pixel
+// starting part way along (after the series approximation or a BLA step) never
+// regenerates more than that.  the orbit is read through a cursor, OrbitArrayCursor
+// or OrbitWaypointCursor, stepping along it in order.
+
+#ifndef REFERENCE_ORBIT_H
+#define REFERENCE_ORBIT_H
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <stdint.h>
+#include <mpfr.h>
+
+#define MPFR_SQUARE_CROSS_BITS 1536 // the mpfr loop, and the orbit's, square x+y for 2*x*y from here
+#define ORBIT_CORRECTION_MAX     127 // ulps a stored correction can be, more is a waypoint
+#define ORBIT_WAYPOINT_SPACING  256   // most points between waypoints
+
+// a stored point of a compressed orbit
+struct OrbitWaypoint { unsigned int n; double re, im; };
+typedef struct OrbitWaypoint OrbitWaypoint;
+
+// one step of the regenerated orbit, the compressor and the cursors must round alike
+inline void orbit_step(const double cx, const double cy, double *x, double *y)
+{
+    const double xtemp = (*x) * (*x) - (*y) * (*y) + cx;
+    *y = 2.0 * (*x) * (*y) + cy;
+    *x = xtemp;
+}
+
+// a double as an integer that goes up by one from each double to the next, -0.0
+// just below +0.0, so two doubles are their difference in ulps apart
+inline int64_t orbit_ulps(const double v)
+{
+    int64_t i;
+    memcpy(&i, &v, sizeof(i));
+    return (i >= 0) ? i : -1 - (i & INT64_MAX);
+}
+
+// v moved on by ulps doubles
+inline double orbit_correct(const double v, const int ulps)
+{
+    const int64_t k = orbit_ulps(v) + ulps;
+    const int64_t i = (k >= 0) ? k : ((-1 - k) | INT64_MIN);
+    double r;
+    memcpy(&r, &i, sizeof(r));
+    return r;
+}
+
+class ReferenceOrbit
+{
+  public:
+    ReferenceOrbit();
+    ~ReferenceOrbit();
+
+    ReferenceOrbit(ReferenceOrbit &other) = delete;
+    void operator=(const ReferenceOrbit&) = delete;
+
+    // iterate z = z^2 + c from z = 0 at c = cx + i*cy, with precision bits, until
+    // |z| > 2 or maxiter steps.  Z_0 .. Z_n are kept, always at least Z_0 and Z_1.
+    void compute(mpfr_srcptr cx, mpfr_srcptr cy, const int precision, const unsigned int maxiter);
+    // iterate on from the last point, if the orbit hasn't escaped, until maxiter steps
+    void extend(const unsigned int maxiter);
+
+    // true when the orbit is of exactly cx + i*cy (at whatever precision it was given)
+    bool sameCentre(mpfr_srcptr cx, mpfr_srcptr cy);
+    // and was iterated with at least precision bits
+    bool matches(mpfr_srcptr cx, mpfr_srcptr cy, const int precision);
+
+    // write the orbit to path, false if it couldn't be
+    bool save(const char *path);
+    // read an orbit of cx + i*cy back from path (memory mapped), false if the file is
+    // of some other centre, stored the other way (compressed or not) or not an orbit
+    // file at all
+    bool load(const char *path, mpfr_srcptr cx, mpfr_srcptr cy);
+    // cx + i*cy exactly, as hex floats "cx,cy"
+    static std::string centreKey(mpfr_srcptr cx, mpfr_srcptr cy);
+    // of the orbit, empty if none has been computed
+    std::string key();
+
+    // keep waypoints rather than every point.  changing it drops the orbit
+    void setCompressed(const bool compressed);
+    bool compressed() { return m_compressed; }
+
+    // number of points in the orbit, Z_0 .. Z_length()-1
+    unsigned int length() { return m_length; }
+    // true when the reference itself escaped before maxiter
+    bool escaped() { return m_escaped; }
+    // every point, when not compressed
+    const double* re() { return m_re.data(); }
+    const double* im() { return m_im.data(); }
+    // the waypoints of a compressed orbit, the first is Z_0
+    const OrbitWaypoint* waypoints() { return m_waypoints.data(); }
+    unsigned int waypointCount() { return (unsigned int)m_waypoints.size(); }
+    // and its corrections, re then im for each point (0 at a waypoint)
+    const int8_t* corrections() { return m_corrections.data(); }
+    // C rounded to double, the regenerated points step with it
+    double cxd() { return m_cxd; }
+    double cyd() { return m_cyd; }
+    // memory held by the points
+    size_t bytes();
+    int precision() { return m_precision; }
+    // changes whenever the points do, so tables built from them know they are stale
+    unsigned int generation() { return m_generation; }
+
+  private:
+    void set_precision(const int precision);
+    void reserve(const unsigned int maxiter);
+    void iterate(const unsigned int maxiter);
+    void set_key(mpfr_srcptr cx, mpfr_srcptr cy);
+    void clear_points();
+
+    int m_precision;
+    mpfr_t m_keyx, m_keyy; // cx, cy as given, at their own precision
+    mpfr_t m_cx, m_cy;
+    mpfr_t m_x, m_y, m_xsq, m_ysq, m_tmp;
+    std::vector<double> m_re, m_im;
+    bool m_compressed;
+    std::vector<OrbitWaypoint> m_waypoints;
+    std::vector<int8_t> m_corrections;
+    double m_cxd, m_cyd;
+    double m_tailx, m_taily; // the last point in double, where compressing carries on
+    unsigned int m_length;
+    bool m_escaped;
+    unsigned int m_generation;
+};
+
+// ----------------------------------------------------------------------------
+// reads the points of an uncompressed orbit, Z_n at index n
+//
+class OrbitArrayCursor
+{
+  public:
+    OrbitArrayCursor(ReferenceOrbit *orbit)
+     : m_re(orbit->re()), m_im(orbit->im()), m_length(orbit->length()), m_n(0) {}
+
+    unsigned int length() const { return m_length; }
+    void seek(const unsigned int n) { m_n = n; }
+    void next() { m_n++; }
+    double re() const { return m_re[m_n]; }
+    double im() const { return m_im[m_n]; }
+
+  private:
+    const double *m_re, *m_im;
+    unsigned int m_length;
+    unsigned int m_n;
+};
+
+// ----------------------------------------------------------------------------
+// regenerates the points of a compressed orbit.  next() is one corrected double
+// step (or a waypoint), seek() goes back to the waypoint at or before n unless n is
+// further along the segment the cursor is already in.
+//
+class OrbitWaypointCursor
+{
+  public:
+    OrbitWaypointCursor(ReferenceOrbit *orbit)
+     : m_waypoints(orbit->waypoints()), m_corrections(orbit->corrections()),
+       m_count(orbit->waypointCount()), m_length(orbit->length()),
+       m_cx(orbit->cxd()), m_cy(orbit->cyd()), m_n(0), m_x(0.0), m_y(0.0), m_next(0), m_nextn(0)
+    {
+        if (m_count > 0) {
+            restart(0);
+        }
+    }
+
+    unsigned int length() const { return m_length; }
+    void seek(const unsigned int n)
+    {
+        if ((n < m_n) || (n >= m_nextn)) {
+            // the last waypoint at or before n
+            unsigned int lo = 0, hi = m_count;
+            while (hi - lo > 1) {
+                unsigned int mid = (lo + hi) / 2;
+                if (m_waypoints[mid].n <= n) { lo = mid; } else { hi = mid; }
+            }
+            restart(lo);
+        }
+        while (m_n < n) { next(); }
+    }
+    void next()
+    {
+        m_n++;
+        if ((m_n == m_nextn) && (m_next < m_count)) {
+            restart(m_next);
+        } else {
+            orbit_step(m_cx, m_cy, &m_x, &m_y);
+            m_x = orbit_correct(m_x, m_corrections[2 * (size_t)m_n]);
+            m_y = orbit_correct(m_y, m_corrections[2 * (size_t)m_n + 1]);
+        }
+    }
+    double re() const { return m_x; }
+    double im() const { return m_y; }
+
+  private:
+    // at waypoint w
+    void restart(const unsigned int w)
+    {
+        m_n = m_waypoints[w].n;
+        m_x = m_waypoints[w].re;
+        m_y = m_waypoints[w].im;
+        m_next = w + 1;
+        m_nextn = (m_next < m_count) ? m_waypoints[m_next].n : m_length;
+    }
+
+    const OrbitWaypoint *m_waypoints;
+    const int8_t *m_corrections;
+    unsigned int m_count;
+    unsigned int m_length;
+    double m_cx, m_cy;
+    unsigned int m_n;     // the point the cursor is at
+    double m_x, m_y;
+    unsigned int m_next;  // the waypoint after it
+    unsigned int m_nextn; // and its index, m_length past the last one
+};
+
+#endif /* REFERENCE_ORBIT_H */
@@ -0,0 +1,151 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// SeriesApproximation.cpp
+
+#include "SeriesApproximation.h"
+
+#define SERIES_PROBES 8
+
+// |x| + |y|, a cheap stand in for the modulus (never smaller than it)
+static inline floatexp norm1(const floatexp &x, const floatexp &y)
+{
+    floatexp ax = (x < floatexp(0)) ? -x : x;
+    floatexp ay = (y < floatexp(0)) ? -y : y;
+    return ax + ay;
+}
+
+// (xr + i*xi) * (yr + i*yi)
+static inline void cmul(const floatexp &xr, const floatexp &xi, const floatexp &yr, const floatexp &yi,
+                        floatexp *r, floatexp *i)
+{
+    floatexp re = xr * yr - xi * yi;
+    *i = xr * yi + xi * yr;
+    *r = re;
+}
+
+// one step along the orbit, C = 2*Z*C + 2*A*B, B = 2*Z*B + A^2, A = 2*Z*A + 1
+static inline void step(const floatexp &Zx, const floatexp &Zy, floatexp c[6])
+{
+    const floatexp two(2);
+    floatexp tr, ti, ur, ui;
+    cmul(Zx, Zy, c[4], c[5], &tr, &ti);
+    cmul(c[0], c[1], c[2], c[3], &ur, &ui);
+    c[4] = two * (tr + ur);
+    c[5] = two * (ti + ui);
+    cmul(Zx, Zy, c[2], c[3], &tr, &ti);
+    cmul(c[0], c[1], c[0], c[1], &ur, &ui);
+    c[2] = two * tr + ur;
+    c[3] = two * ti + ui;
+    cmul(Zx, Zy, c[0], c[1], &tr, &ti);
+    c[0] = two * tr + floatexp(1);
+    c[1] = two * ti;
+}
+
+// d = ((C*dc + B)*dc + A)*dc
+static inline void evaluate_at(const floatexp c[6], const floatexp &dcx, const floatexp &dcy, 
+                               floatexp *dx, floatexp *dy)
+{
+    floatexp r, i;
+    cmul(c[4], c[5], dcx, dcy, &r, &i);
+    r = r + c[2];
+    i = i + c[3];
+    cmul(r, i, dcx, dcy, &r, &i);
+    r = r + c[0];
+    i = i + c[1];
+    cmul(r, i, dcx, dcy, dx, dy);
+}
+
+// CONSTRUCTORS --------------------------------------------------------------------------
+SeriesApproximation::SeriesApproximation()
+ : m_skip(0)
+{
+}
+
+// PUBLIC METHODS ------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------
+unsigned int SeriesApproximation::compute(ReferenceOrbit *orbit, 
+                        const floatexp dcx0, const floatexp dcy0, 
+                        const floatexp dx, const floatexp dy,
+                        const unsigned int xsize, const unsigned int ysize,
+                        const unsigned int maxiter)
+{
+    if (orbit->compressed()) {
+        OrbitWaypointCursor cursor(orbit);
+        return compute_along(cursor, dcx0, dcy0, dx, dy, xsize, ysize, maxiter);
+    }
+    OrbitArrayCursor cursor(orbit);
+    return compute_along(cursor, dcx0, dcy0, dx, dy, xsize, ysize, maxiter);
+}
+
+// ---------------------------------------------------------------------------------------
+void SeriesApproximation::evaluate(const floatexp dcx, const floatexp dcy, floatexp *dx, floatexp *dy) const
+{
+    evaluate_at(m_coeffs, dcx, dcy, dx, dy);
+}
+
+// PRIVATE METHODS -----------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------
+// compute() with the orbit read in order through a cursor
+//
+template<typename Orbit>
+unsigned int SeriesApproximation::compute_along(Orbit &orbit, 
+                        const floatexp dcx0, const floatexp dcy0, 
+                        const floatexp dx, const floatexp dy,
+                        const unsigned int xsize, const unsigned int ysize,
+                        const unsigned int maxiter)
+{
+    const floatexp two(2), tolerance(SERIES_TOLERANCE);
+
+    // corners and edge midpoints of the frame
+    const unsigned int px[SERIES_PROBES] = { 0, xsize / 2, xsize - 1, xsize - 1, xsize - 1, xsize / 2, 0, 0 };
+    const unsigned int py[SERIES_PROBES] = { 0, 0, 0, ysize / 2, ysize - 1, ysize - 1, ysize - 1, ysize / 2 };
+    floatexp pcx[SERIES_PROBES], pcy[SERIES_PROBES], pdx[SERIES_PROBES], pdy[SERIES_PROBES];
+    for (int p = 0; p < SERIES_PROBES; p++)
+    {
+        pcx[p] = dcx0 + floatexp((double)px[p]) * dx;
+        pcy[p] = dcy0 + floatexp((double)py[p]) * dy;
+    }
+
+    floatexp coeffs[6]; // A, B, C (re, im), all 0 at n = 0
+    m_skip = 0;
+    for (int k = 0; k < 6; k++) { m_coeffs[k] = floatexp(); }
+
+    // stop short of the end of the orbit, pixels rebase there
+    unsigned int last = (orbit.length() - 1 < maxiter) ? orbit.length() - 1 : maxiter;
+    orbit.seek(0);
+    for (unsigned int n = 0; n + 1 < last; n++)
+    {
+        const floatexp Zx(orbit.re()), Zy(orbit.im());
+        step(Zx, Zy, coeffs);
+
+        // the probes take one real step, d = 2*Z*d + d^2 + dc, and the series has
+        // to land on them
+        double dmax = 0.0;
+        bool valid = true;
+        for (int p = 0; p < SERIES_PROBES && valid; p++)
+        {
+            floatexp tr, ti, ur, ui, sx, sy;
+            cmul(Zx, Zy, pdx[p], pdy[p], &tr, &ti);
+            cmul(pdx[p], pdy[p], pdx[p], pdy[p], &ur, &ui);
+            pdx[p] = two * tr + ur + pcx[p];
+            pdy[p] = two * ti + ui + pcy[p];
+
+            evaluate_at(coeffs, pcx[p], pcy[p], &sx, &sy);
+            floatexp size = norm1(pdx[p], pdy[p]);
+            valid = !(tolerance * size < norm1(sx - pdx[p], sy - pdy[p]));
+            dmax = ((double)size > dmax) ? (double)size : dmax;
+        }
+
+        // no pixel may escape inside the skipped iterations, |z_n+1| <= |Z_n+1| + |d|
+        // (with room for pixels between the probes)
+        orbit.next();
+        double Z = sqrt(orbit.re() * orbit.re() + orbit.im() * orbit.im()) + 2.0 * dmax;
+        if (!valid || (Z * Z > 4.0)) {
+            break;
+        }
+        m_skip = n + 1;
+        for (int k = 0; k < 6; k++) { m_coeffs[k] = coeffs[k]; }
+    }
+    return m_skip;
+}
@@ -0,0 +1,56 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// SeriesApproximation.h
+
+// series approximation for the perturbation engine.  along the reference orbit the
+// delta of every pixel is, to start with, a polynomial in its offset dc
+//
+//     d_n = A_n*dc + B_n*dc^2 + C_n*dc^3
+//     A_n+1 = 2*Z_n*A_n + 1,  B_n+1 = 2*Z_n*B_n + A_n^2,  C_n+1 = 2*Z_n*C_n + 2*A_n*B_n
+//
+// so for as long as that holds over the whole frame every pixel can start at
+// iteration n with d_n from the polynomial instead of iterating up to it.
+
+#ifndef SERIES_APPROXIMATION_H
+#define SERIES_APPROXIMATION_H
+
+#include "FloatExp.h"
+#include "ReferenceOrbit.h"
+
+#define SERIES_TOLERANCE 1e-12 // largest relative error of the series at a probe
+
+class SeriesApproximation
+{
+  public:
+    SeriesApproximation();
+    ~SeriesApproximation() {}
+
+    // work the coefficients along orbit and find how many iterations every pixel of an
+    // xsize by ysize frame can skip, pixel (Dx, Dy) being dc = dc0 + (Dx*dx, Dy*dy)
+    // from the reference.  the series is checked each step against the real deltas of
+    // probe pixels round the edge of the frame and stops before it drifts from them by
+    // more than SERIES_TOLERANCE, or before any pixel could have escaped.
+    unsigned int compute(ReferenceOrbit *orbit, 
+                        const floatexp dcx0, const floatexp dcy0, 
+                        const floatexp dx, const floatexp dy,
+                        const unsigned int xsize, const unsigned int ysize,
+                        const unsigned int maxiter);
+
+    // iterations every pixel skips, 0 when the series is no use
+    unsigned int skip() const { return m_skip; }
+
+    // d at iteration skip() for the pixel dcx + i*dcy
+    void evaluate(const floatexp dcx, const floatexp dcy, floatexp *dx, floatexp *dy) const;
+
+  private:
+    template<typename Orbit>
+    unsigned int compute_along(Orbit &orbit, 
+                        const floatexp dcx0, const floatexp dcy0, 
+                        const floatexp dx, const floatexp dy,
+                        const unsigned int xsize, const unsigned int ysize,
+                        const unsigned int maxiter);
+
+    unsigned int m_skip;
+    floatexp m_coeffs[6]; // A, B, C (re, im) at m_skip
+};
+
+#endif /* SERIES_APPROXIMATION_H */
@@ -0,0 +1,83 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// ThreadPool.cpp
+
+#include "ThreadPool.h"
+
+// CONSTRUCTORS --------------------------------------------------------------------------
+ThreadPool::ThreadPool(const unsigned int nthreads)
+ : m_nthreads(nthreads),
+   m_job(NULL),
+   m_arg(NULL),
+   m_generation(0),
+   m_running(0),
+   m_shutdown(false)
+{
+    if (m_nthreads < 1) {
+        m_nthreads = 1;
+    }
+    m_threads.reserve(m_nthreads);
+    for (unsigned int tid = 0; tid < m_nthreads; tid++)
+    {
+        m_threads.push_back(std::thread(&ThreadPool::workerLoop, this, tid));
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_shutdown = true;
+    }
+    m_startCV.notify_all();
+    for (auto& th : m_threads) th.join();
+}
+
+// PUBLIC METHODS ------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------
+// hand the job to every worker, then sleep until the last one reports back
+//
+void ThreadPool::runFrame(frame_job job, void* arg)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_job = job;
+    m_arg = arg;
+    m_running = m_nthreads;
+    m_generation++;
+    m_startCV.notify_all();
+
+    m_doneCV.wait(lock, [this]{ return m_running == 0; });
+    m_job = NULL;
+    m_arg = NULL;
+}
+
+// PRIVATE METHODS -----------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------
+// each worker parks on m_startCV until a new generation (frame) is posted
+//
+void ThreadPool::workerLoop(const unsigned int tid)
+{
+    unsigned long seen = 0;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_startCV.wait(lock, [this, seen]{ return m_shutdown || m_generation != seen; });
+        if (m_shutdown) {
+            return;
+        }
+        seen = m_generation;
+        frame_job job = m_job;
+        void* arg = m_arg;
+
+        lock.unlock();
+        job(arg, tid);
+        lock.lock();
+
+        if (--m_running == 0) {
+            m_doneCV.notify_one();
+        }
+    }
+}
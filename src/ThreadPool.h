@@ -0,0 +1,50 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// ThreadPool.h
+
+// a fixed set of long lived worker threads that are handed one job per frame and
+// park on a condition variable between frames
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// signature of a frame job, called once on every worker with its thread id
+typedef void (*frame_job)(void* arg, const unsigned int tid);
+
+class ThreadPool
+{
+  public:
+    ThreadPool(const unsigned int nthreads);
+    ~ThreadPool();
+
+    // the pool owns its threads so should not be cloneable or assignable
+    ThreadPool(ThreadPool &other) = delete;
+    void operator=(const ThreadPool&) = delete;
+
+    // run job(arg, tid) on every worker and block until they have all returned
+    void runFrame(frame_job job, void* arg);
+
+    unsigned int size() { return m_nthreads; }
+
+  private:
+    void workerLoop(const unsigned int tid);
+
+    unsigned int m_nthreads;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_startCV;   // workers wait here between frames
+    std::condition_variable m_doneCV;    // runFrame waits here for the frame to finish
+
+    frame_job m_job;
+    void* m_arg;
+    unsigned long m_generation;          // bumped once per frame to wake the workers
+    unsigned int m_running;              // workers still busy with the current frame
+    bool m_shutdown;
+};
+
+#endif /* THREAD_POOL_H */
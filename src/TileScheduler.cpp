@@ -0,0 +1,160 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// TileScheduler.cpp
+
+#include "TileScheduler.h"
+
+// CONSTRUCTORS --------------------------------------------------------------------------
+TileScheduler::TileScheduler(const unsigned int nworkers)
+ : m_nworkers(nworkers),
+   m_ntiles(0),
+   m_spawning(false),
+   m_pending(0),
+   m_pushes(0)
+{
+    if (m_nworkers < 1) {
+        m_nworkers = 1;
+    }
+    m_queues = new WorkQueue[m_nworkers];
+    for (unsigned int w = 0; w < m_nworkers; w++)
+    {
+        m_queues[w].head = 0;
+        m_queues[w].tail = 0;
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+TileScheduler::~TileScheduler()
+{
+    delete [] m_queues;
+}
+
+// PUBLIC METHODS ------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------
+// each worker is dealt a contiguous run of tiles (in row order) so neighbouring tiles
+// stay on the same core until somebody has to steal them.  a deque is popped from
+// the back, so the tiles pushed on top of its own are at most the three left over
+// from each split down to the deepest plus the four from that one, 3 * depth + 1,
+// and room for them is kept so a push never allocates
+//
+void TileScheduler::reset(const unsigned int xsize, const unsigned int ysize, const unsigned int size,
+                          const unsigned int depth)
+{
+    unsigned int tiles_x = (xsize + size - 1) / size;
+    unsigned int tiles_y = (ysize + size - 1) / size;
+    m_ntiles = tiles_x * tiles_y;
+    m_pending = m_ntiles;
+    m_spawning = (depth > 0);
+
+    for (unsigned int w = 0; w < m_nworkers; w++)
+    {
+        unsigned int first = (w * m_ntiles) / m_nworkers;
+        unsigned int last = ((w + 1) * m_ntiles) / m_nworkers;
+        WorkQueue *queue = &(m_queues[w]);
+
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->tiles.reserve(last - first + (m_spawning ? 3 * depth + 1 : 0));
+        queue->tiles.resize(last - first);
+        for (unsigned int t = first; t < last; t++)
+        {
+            Tile *tile = &(queue->tiles[t - first]);
+            tile->x0 = (t % tiles_x) * size;
+            tile->y0 = (t / tiles_x) * size;
+            tile->x1 = (tile->x0 + size < xsize) ? tile->x0 + size : xsize;
+            tile->y1 = (tile->y0 + size < ysize) ? tile->y0 + size : ysize;
+        }
+        queue->head = 0;
+        queue->tail = last - first;
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// own work first, then go round the other workers looking for something to steal.
+// with every deque empty but tiles still running, one of them may yet push more, so
+// sleep until a push lands after the look round began or the last tile is done.
+// tiles that never push can't add work, and empty deques mean the frame is over
+//
+bool TileScheduler::next(const unsigned int tid, Tile *tile)
+{
+    while (true)
+    {
+        const unsigned long pushes = m_pushes;
+
+        if (popBack(&(m_queues[tid]), tile)) {
+            return true;
+        }
+        for (unsigned int i = 1; i < m_nworkers; i++)
+        {
+            if (stealFront(&(m_queues[(tid + i) % m_nworkers]), tile)) {
+                return true;
+            }
+        }
+        if (!m_spawning) {
+            return false;
+        }
+
+        std::unique_lock<std::mutex> lock(m_idleMutex);
+        m_idleCV.wait(lock, [this, pushes]{ return (m_pending == 0) || (m_pushes != pushes); });
+        if (m_pending == 0) {
+            return false;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+// the last tile done wakes everyone still waiting so they can leave the frame
+//
+void TileScheduler::done()
+{
+    if (m_spawning && (--m_pending == 0)) {
+        std::lock_guard<std::mutex> lock(m_idleMutex);
+        m_idleCV.notify_all();
+    }
+}
+
+// ---------------------------------------------------------------------------------------
+void TileScheduler::push(const unsigned int tid, const Tile &tile)
+{
+    WorkQueue *queue = &(m_queues[tid]);
+
+    m_pending++;
+    {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if (queue->tail < queue->tiles.size()) {
+            queue->tiles[queue->tail] = tile;
+        } else {
+            queue->tiles.push_back(tile);
+        }
+        queue->tail++;
+    }
+
+    std::lock_guard<std::mutex> lock(m_idleMutex);
+    m_pushes++;
+    m_idleCV.notify_one();
+}
+
+// PRIVATE METHODS -----------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------------------
+bool TileScheduler::popBack(WorkQueue *queue, Tile *tile)
+{
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if (queue->head == queue->tail) {
+        return false;
+    }
+    queue->tail--;
+    *tile = queue->tiles[queue->tail];
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------
+bool TileScheduler::stealFront(WorkQueue *queue, Tile *tile)
+{
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if (queue->head == queue->tail) {
+        return false;
+    }
+    *tile = queue->tiles[queue->head];
+    queue->head++;
+    return true;
+}
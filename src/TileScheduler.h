@@ -0,0 +1,74 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// TileScheduler.h
+
+// splits a frame into small square tiles and hands them out to the workers of the
+// thread pool. each worker owns a deque of tiles, when it runs dry it steals from
+// the front of another worker's deque so the frame finishes when the total work is
+// done rather than when the slowest band is done.
+//
+// a tile can also be a task that spawns more: a worker pushes new tiles onto its
+// own deque while it runs one, and the frame is only over once every tile handed
+// out has been reported done.  until then a worker with nothing to take sleeps on
+// a condition variable rather than spinning.
+
+#ifndef TILE_SCHEDULER_H
+#define TILE_SCHEDULER_H
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+#define TILE_SIZE 16
+
+// a rectangle of pixels, x1 and y1 are exclusive
+struct Tile { unsigned int x0, y0, x1, y1; };
+typedef struct Tile Tile;
+
+class TileScheduler
+{
+  public:
+    TileScheduler(const unsigned int nworkers);
+    ~TileScheduler();
+
+    TileScheduler(TileScheduler &other) = delete;
+    void operator=(const TileScheduler&) = delete;
+
+    // cut an xsize by ysize frame into size by size tiles and deal them out across the deques.
+    // depth is how many times a tile can split (each split pushing four), 0 if tiles never push
+    void reset(const unsigned int xsize, const unsigned int ysize, const unsigned int size = TILE_SIZE,
+               const unsigned int depth = 0);
+
+    // get the next tile for worker tid, false once there is no work left anywhere
+    // and no tile still running that could add more
+    bool next(const unsigned int tid, Tile *tile);
+    // a tile from next is finished, every one must be reported
+    void done();
+    // more work found while running a tile, onto the back of worker tid's deque
+    void push(const unsigned int tid, const Tile &tile);
+
+    unsigned int tileCount() { return m_ntiles; }
+
+  private:
+    // a deque of tiles, the owner pops from the back, thieves take from the front
+    struct WorkQueue {
+        std::mutex mutex;
+        std::vector<Tile> tiles;
+        unsigned int head;
+        unsigned int tail;
+    };
+
+    bool popBack(WorkQueue *queue, Tile *tile);
+    bool stealFront(WorkQueue *queue, Tile *tile);
+
+    unsigned int m_nworkers;
+    unsigned int m_ntiles;
+    WorkQueue *m_queues;
+    bool m_spawning;                     // tiles can push more, so empty deques aren't the end
+    std::atomic<unsigned int> m_pending; // tiles queued or running
+    std::atomic<unsigned long> m_pushes; // bumped by every push, so a sleeper knows to look again
+    std::mutex m_idleMutex;
+    std::condition_variable m_idleCV;    // workers wait here for a push or the last done
+};
+
+#endif /* TILE_SCHEDULER_H */
@@ -30,7 +30,8 @@ static void run_program(CmdOptions* cmdOptions)
     MandelbrotAdapter* mandAdapter = new MandelbrotAdapter(cmdOptions);
     ImageFile* imgFile = new ImageFile();
     ImageData* imgData = new ImageData(cmdOptions->getWidth(), cmdOptions->getHeight(), RGB);
-    bool ok = true;
+    const int frames = cmdOptions->getFrames();
+    bool ok = (frames != 1);
 
     // do first image
     mandAdapter->getTextureData(imgData);
@@ -41,7 +42,11 @@ static void run_program(CmdOptions* cmdOptions)
         mandAdapter->zoomIn();
         mandAdapter->getTextureData(imgData);
         imgFile->writeImage(mandAdapter->framecount(), imgData);
-        ok = imgData->isNotBottomedOut(mandAdapter->framecount());
+        if (frames > 0) {
+            ok = (mandAdapter->framecount() < (unsigned int)frames);
+        } else {
+            ok = imgData->isNotBottomedOut(mandAdapter->framecount());
+        }
     }
     mandAdapter->cleanUp();
 }
@@ -0,0 +1,618 @@
+/* ----------------------------------------------------------------------------
+ * Micro benchmarks for libmandelbrot.so
+ *
+ * Each section prints a per frame time so runs can be compared before and
+ * after a change to the library.
+ * - use 'make Mandelbrot_Bench && ./Mandelbrot_Bench' to run them
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "MandelbrotMpfr.h"
+#include "ThreadPool.h"
+#include "FloatExp.h"
+
+typedef std::chrono::steady_clock bench_clock;
+
+static double elapsed_us(bench_clock::time_point start, const int frames)
+{
+    std::chrono::duration<double, std::micro> us = bench_clock::now() - start;
+    return us.count() / frames;
+}
+
+// a job that does almost nothing so only the dispatch cost is measured
+static void empty_job(void* arg, const unsigned int tid)
+{
+    ((volatile unsigned int*)arg)[tid]++;
+}
+
+/* ----------------------------------------------------------------------------
+ * dispatch overhead - spawning ncpus std::threads per frame (the old
+ * mandelbrot_mpfr_c) against waking the parked workers of a ThreadPool
+ */
+static void bench_dispatch(const int ncpus, const int frames)
+{
+    std::vector<unsigned int> counts(ncpus, 0);
+
+    bench_clock::time_point start = bench_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        std::vector<std::thread> threads;
+        for (int tid = 0; tid < ncpus; tid++)
+        {
+            threads.push_back(std::thread(empty_job, counts.data(), tid));
+        }
+        for (auto& th : threads) th.join();
+    }
+    printf("  spawn/join per frame   %10.2f us\n", elapsed_us(start, frames));
+
+    ThreadPool pool(ncpus);
+    start = bench_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        pool.runFrame(empty_job, counts.data());
+    }
+    printf("  thread pool per frame  %10.2f us\n", elapsed_us(start, frames));
+}
+
+/* ----------------------------------------------------------------------------
+ * whole frames at a small size where the per frame overhead dominates
+ */
+static void bench_frames(MandelbrotMpfr* mpfr, const unsigned int size, const int frames)
+{
+    unsigned char *bytearray = (unsigned char*)calloc((size_t)(size * size * 3), sizeof(unsigned char));
+
+    mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "-0.75", "0.1");
+    mpfr->mandelbrot_mpfr_c(size, size, &bytearray); // warm up
+
+    bench_clock::time_point start = bench_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        mpfr->mandelbrot_mpfr_c(size, size, &bytearray);
+    }
+    printf("  %4ux%-4u frame        %10.2f us\n", size, size, elapsed_us(start, frames));
+
+    free(bytearray);
+}
+
+/* ----------------------------------------------------------------------------
+ * GMP/MPFR temporaries from the default (malloc) allocator against the per
+ * worker arenas, frames per second at increasing precision
+ */
+static void bench_allocator(MandelbrotMpfr* mpfr, const unsigned int size)
+{
+    const int precisions[] = { 512, 2048, 8192 };
+    const int floor = mpfr->getPrecision();
+    unsigned char *bytearray = (unsigned char*)calloc((size_t)(size * size * 3), sizeof(unsigned char));
+
+    mpfr->initialize_c("0.30", "0.55", "0.50", "0.75", "0.425", "0.625");
+    for (int precision : precisions)
+    {
+        mpfr->setPrecision(precision);
+        for (int arena = 0; arena < 2; arena++)
+        {
+            mpfr->setUseArena(arena == 1);
+            mpfr->mandelbrot_mpfr_c(size, size, &bytearray); // warm up, builds worker state
+
+            int frames = 0;
+            bench_clock::time_point start = bench_clock::now();
+            do {
+                mpfr->mandelbrot_mpfr_c(size, size, &bytearray);
+                frames++;
+            } while (std::chrono::duration<double>(bench_clock::now() - start).count() < 1.0);
+
+            double fps = frames / std::chrono::duration<double>(bench_clock::now() - start).count();
+            printf("  %5d bits %-8s %8.2f frames/s\n", precision, arena ? "arena" : "malloc", fps);
+        }
+    }
+    mpfr->setUseArena(false);
+    mpfr->setPrecision(floor);
+
+    free(bytearray);
+}
+
+/* ----------------------------------------------------------------------------
+ * the double tier row kernel at each instruction set the cpu supports
+ */
+static void bench_simd(MandelbrotMpfr* mpfr, const unsigned int size, const int frames)
+{
+    unsigned char *bytearray = (unsigned char*)calloc((size_t)(size * size * 3), sizeof(unsigned char));
+
+    mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "-0.75", "0.1");
+    mpfr->setTier(TIER_DOUBLE);
+    for (int level = SIMD_SCALAR; level <= simd_best_level(); level++)
+    {
+        mpfr->setSimdLevel((SimdLevel)level);
+        mpfr->mandelbrot_mpfr_c(size, size, &bytearray); // warm up
+
+        bench_clock::time_point start = bench_clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            mpfr->mandelbrot_mpfr_c(size, size, &bytearray);
+        }
+        printf("  %-8s frame          %10.2f us\n", simd_level_name((SimdLevel)level), elapsed_us(start, frames));
+    }
+    mpfr->setTier(TIER_AUTO);
+    mpfr->setSimdLevel(simd_default_level());
+
+    free(bytearray);
+}
+
+/* ----------------------------------------------------------------------------
+ * a frame past long double range, every pixel in mpfr against every pixel as
+ * a double offset from one mpfr reference orbit
+ */
+static void bench_perturbation(MandelbrotMpfr* mpfr, const unsigned int size, const int zooms)
+{
+    unsigned char *bytearray = (unsigned char*)calloc((size_t)(size * size * 3), sizeof(unsigned char));
+
+    mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "0.0", "1.0");
+    for (int zoom = 0; zoom < zooms; zoom++) { mpfr->zoom_in(size, size); }
+
+    // mpfr, perturbation, then perturbation with series approximation, BLA, both
+    for (int engine = 0; engine < 5; engine++)
+    {
+        mpfr->setUsePerturbation(engine > 0);
+        mpfr->setUseSeries(engine == 2 || engine == 4);
+        mpfr->setUseBla(engine >= 3);
+        bench_clock::time_point start = bench_clock::now();
+        mpfr->mandelbrot_mpfr_c(size, size, &bytearray);
+        printf("  %-22s %4d bits %10.2f us  skip %-5u bla %zu bytes\n", MandelbrotMpfr::tierName(mpfr->getFrameTier()), 
+               mpfr->getFramePrecision(), elapsed_us(start, 1), mpfr->getSeriesSkip(), mpfr->getBlaBytes());
+    }
+    mpfr->setUseBla(false);
+    mpfr->setUsePerturbation(false);
+    mpfr->setUseSeries(true);
+
+    free(bytearray);
+}
+
+/* ----------------------------------------------------------------------------
+ * the whole set in view, in the double tier and in mpfr, with and without the
+ * main cardioid and period 2 bulb pixels rejected up front
+ */
+static void bench_bulbs(MandelbrotMpfr* mpfr, const unsigned int size)
+{
+    const NumericTier tiers[] = { TIER_DOUBLE, TIER_MPFR };
+    unsigned char *bytearray = (unsigned char*)calloc((size_t)(size * size * 3), sizeof(unsigned char));
+
+    mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "0.0", "1.0");
+    for (NumericTier tier : tiers)
+    {
+        double us[2];
+        mpfr->setTier(tier);
+        for (int reject = 0; reject < 2; reject++)
+        {
+            mpfr->setUseBulbRejection(reject != 0);
+            mpfr->mandelbrot_mpfr_c(size, size, &bytearray); // warm up, builds worker state
+            bench_clock::time_point start = bench_clock::now();
+            mpfr->mandelbrot_mpfr_c(size, size, &bytearray);
+            us[reject] = elapsed_us(start, 1);
+        }
+        printf("  %-6s iterated %10.2f us  rejected %10.2f us  x%.1f (%u of %u pixels)\n", 
+               MandelbrotMpfr::tierName(tier), us[0], us[1], us[0] / us[1], 
+               mpfr->getRejectedPixels(), size * size);
+    }
+    mpfr->setTier(TIER_AUTO);
+
+    free(bytearray);
+}
+
+/* ----------------------------------------------------------------------------
+ * a frame on the period 3 minibrot at maxiter 10000, the cycle check off then on
+ */
+static void bench_periodicity(MandelbrotMpfr* mpfr, const unsigned int size)
+{
+    const NumericTier tiers[] = { TIER_DOUBLE, TIER_LONG_DOUBLE, TIER_DOUBLE_DOUBLE, TIER_FIXED_POINT, TIER_MPFR };
+    const int maxiter = mpfr->getMaxIter();
+    unsigned char *bytearray = (unsigned char*)calloc((size_t)(size * size * 3), sizeof(unsigned char));
+
+    mpfr->initialize_c("-1.7690", "-1.7400", "-0.0145", "0.0145", "0.0", "1.0");
+    mpfr->setMaxIter(10000);
+    for (NumericTier tier : tiers)
+    {
+        double us[2];
+        mpfr->setTier(tier);
+        for (int periodic = 0; periodic < 2; periodic++)
+        {
+            mpfr->setUsePeriodicity(tier, periodic != 0);
+            mpfr->mandelbrot_mpfr_c(size, size, &bytearray); // warm up, builds worker state
+            bench_clock::time_point start = bench_clock::now();
+            mpfr->mandelbrot_mpfr_c(size, size, &bytearray);
+            us[periodic] = elapsed_us(start, 1);
+        }
+        printf("  %-14s off %12.2f us  on %12.2f us  x%.1f\n", 
+               MandelbrotMpfr::tierName(tier), us[0], us[1], us[0] / us[1]);
+    }
+    mpfr->setMaxIter(maxiter);
+    mpfr->setTier(TIER_AUTO);
+
+    free(bytearray);
+}
+
+/* ----------------------------------------------------------------------------
+ * subdivision against every pixel, zoomed toward a minibrot on the real axis so the
+ * frame is mostly interior and each tier is run where it would be picked
+ */
+static void bench_subdivision(MandelbrotMpfr* mpfr, const unsigned int size, const int zooms)
+{
+    const NumericTier tiers[] = { TIER_DOUBLE, TIER_LONG_DOUBLE, TIER_DOUBLE_DOUBLE, TIER_FIXED_POINT, TIER_MPFR };
+    const int maxiter = mpfr->getMaxIter();
+    unsigned char *bytearray = (unsigned char*)calloc((size_t)(size * size * 3), sizeof(unsigned char));
+
+    mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "-1.7685736562998", "0.0");
+    for (int zoom = 0; zoom < zooms; zoom++) { mpfr->zoom_in(size, size); }
+    mpfr->setMaxIter(5000);
+    for (NumericTier tier : tiers)
+    {
+        double us[2];
+        mpfr->setTier(tier);
+        for (int subdivide = 0; subdivide < 2; subdivide++)
+        {
+            mpfr->setUseSubdivision(subdivide != 0);
+            mpfr->mandelbrot_mpfr_c(size, size, &bytearray); // warm up, builds worker state
+            bench_clock::time_point start = bench_clock::now();
+            mpfr->mandelbrot_mpfr_c(size, size, &bytearray);
+            us[subdivide] = elapsed_us(start, 1);
+        }
+        printf("  %-14s off %12.2f us  on %12.2f us  x%.1f  (%u filled)\n", 
+               MandelbrotMpfr::tierName(tier), us[0], us[1], us[0] / us[1], mpfr->getFilledPixels());
+    }
+    mpfr->setUseSubdivision(false);
+    mpfr->setMaxIter(maxiter);
+    mpfr->setTier(TIER_AUTO);
+
+    free(bytearray);
+}
+
+/* ----------------------------------------------------------------------------
+ * the mpfr loop on its own, the same frame at each precision
+ */
+static void bench_mpfr_loop(MandelbrotMpfr* mpfr, const unsigned int size)
+{
+    const int precisions[] = { 256, 512, 1024, 2048, 4096 };
+    const int floor = mpfr->getPrecision();
+    unsigned char *bytearray = (unsigned char*)calloc((size_t)(size * size * 3), sizeof(unsigned char));
+
+    mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "0.0", "1.0");
+    for (int zoom = 0; zoom < 100; zoom++) { mpfr->zoom_in(size, size); }
+    mpfr->setTier(TIER_MPFR);
+    for (int precision : precisions)
+    {
+        mpfr->setPrecision(precision);
+        mpfr->mandelbrot_mpfr_c(size, size, &bytearray); // warm up, builds worker state
+        bench_clock::time_point start = bench_clock::now();
+        mpfr->mandelbrot_mpfr_c(size, size, &bytearray);
+        printf("  %4d bits %10.2f us\n", mpfr->getFramePrecision(), elapsed_us(start, 1));
+    }
+    mpfr->setTier(TIER_AUTO);
+    mpfr->setPrecision(floor);
+
+    free(bytearray);
+}
+
+/* ----------------------------------------------------------------------------
+ * the same deep frame in mpfr and in fixed point at each precision (the fixed
+ * point kernels have as many limbs as the mpfr mantissa), one pixel at a time
+ * and across the lanes of each instruction set the cpu supports
+ */
+static void bench_fixed_point(MandelbrotMpfr* mpfr, const unsigned int size)
+{
+    const int precisions[] = { 256, 512, 1024, 2048 };
+    const int floor = mpfr->getPrecision();
+    unsigned char *bytearray = (unsigned char*)calloc((size_t)(size * size * 3), sizeof(unsigned char));
+
+    mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "0.0", "1.0");
+    for (int zoom = 0; zoom < 150; zoom++) { mpfr->zoom_in(size, size); }
+    for (int precision : precisions)
+    {
+        mpfr->setPrecision(precision);
+        mpfr->setTier(TIER_MPFR);
+        mpfr->mandelbrot_mpfr_c(size, size, &bytearray); // warm up, builds worker state
+        bench_clock::time_point start = bench_clock::now();
+        mpfr->mandelbrot_mpfr_c(size, size, &bytearray);
+        double mpfr_us = elapsed_us(start, 1);
+        printf("  %4d bits mpfr                 %10.2f us\n", mpfr->getFramePrecision(), mpfr_us);
+
+        mpfr->setTier(TIER_FIXED_POINT);
+        for (int level = SIMD_SCALAR; level <= simd_best_level(); level++)
+        {
+            mpfr->setSimdLevel((SimdLevel)level);
+            start = bench_clock::now();
+            mpfr->mandelbrot_mpfr_c(size, size, &bytearray);
+            double us = elapsed_us(start, 1);
+            printf("  %4d bits fixed point %-8s %10.2f us  x%.1f (%d limbs)\n", mpfr->getFramePrecision(), 
+                   simd_level_name((SimdLevel)level), us, mpfr_us / us, mpfr->getFixedLimbs());
+        }
+    }
+    mpfr->setTier(TIER_AUTO);
+    mpfr->setSimdLevel(simd_default_level());
+    mpfr->setPrecision(floor);
+
+    free(bytearray);
+}
+
+/* ----------------------------------------------------------------------------
+ * frames between 1e-15 and 1e-60, each in the multi-double tier auto picks for
+ * it, in mpfr and in fixed point at the same frame precision
+ */
+static void bench_multi_double(MandelbrotMpfr* mpfr, const unsigned int size)
+{
+    const int depths[] = { 60, 100, 140, 190 };
+    unsigned char *bytearray = (unsigned char*)calloc((size_t)(size * size * 3), sizeof(unsigned char));
+
+    for (int depth : depths)
+    {
+        mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "0.0", "1.0");
+        for (int zoom = 0; zoom < depth; zoom++) { mpfr->zoom_in(size, size); }
+        mpfr->setTier(TIER_AUTO);
+        mpfr->mandelbrot_mpfr_c(size, size, &bytearray); // warm up, builds worker state
+        const NumericTier tier = mpfr->getFrameTier();
+        bench_clock::time_point start = bench_clock::now();
+        mpfr->mandelbrot_mpfr_c(size, size, &bytearray);
+        double us = elapsed_us(start, 1);
+
+        mpfr->setTier(TIER_MPFR);
+        start = bench_clock::now();
+        mpfr->mandelbrot_mpfr_c(size, size, &bytearray);
+        double mpfr_us = elapsed_us(start, 1);
+
+        mpfr->setTier(TIER_FIXED_POINT);
+        start = bench_clock::now();
+        mpfr->mandelbrot_mpfr_c(size, size, &bytearray);
+        double fixed_us = elapsed_us(start, 1);
+
+        printf("  %3d zooms %4d bits %-14s %10.2f us  mpfr %10.2f us x%.1f  fixed point %10.2f us x%.1f\n",
+               depth, mpfr->getFramePrecision(), MandelbrotMpfr::tierName(tier), us,
+               mpfr_us, mpfr_us / us, fixed_us, fixed_us / us);
+    }
+    mpfr->setTier(TIER_AUTO);
+
+    free(bytearray);
+}
+
+/* ----------------------------------------------------------------------------
+ * a run of frames zooming into a fixed point, with the reference orbit
+ * computed for every frame against one orbit (at the last frame's precision)
+ * shared by them all
+ */
+static void bench_sequence(MandelbrotMpfr* mpfr, const unsigned int size, const int depth, const int frames)
+{
+    unsigned char *bytearray = (unsigned char*)calloc((size_t)(size * size * 3), sizeof(unsigned char));
+    const int maxiter = mpfr->getMaxIter();
+
+    mpfr->setUsePerturbation(true);
+    mpfr->setMaxIter(5000);
+    for (int reuse = 0; reuse < 2; reuse++)
+    {
+        mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "0.0", "1.0");
+        for (int zoom = 0; zoom < depth; zoom++) { mpfr->zoom_in(size, size); }
+        mpfr->setReuseOrbit(reuse == 1);
+        mpfr->setReferencePrecision(0);
+        if (reuse) { mpfr->planZoomSequence(frames - 1, size); }
+
+        bench_clock::time_point start = bench_clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            mpfr->mandelbrot_mpfr_c(size, size, &bytearray);
+            mpfr->zoom_in(size, size);
+        }
+        printf("  %-18s %4d bits %10.2f us/frame\n", reuse ? "one orbit" : "orbit per frame", 
+               mpfr->getFramePrecision(), elapsed_us(start, frames));
+    }
+    mpfr->setReuseOrbit(true);
+    mpfr->setReferencePrecision(0);
+    mpfr->setMaxIter(maxiter);
+    mpfr->setUsePerturbation(false);
+
+    free(bytearray);
+}
+
+/* ----------------------------------------------------------------------------
+ * a perturbation frame with the reference orbit stored in full and as
+ * waypoints, the memory it takes and what regenerating it costs
+ */
+static void bench_orbit_storage(MandelbrotMpfr* mpfr, const unsigned int size, const char *mx, const char *my, 
+                                const int zooms, const int maxiter)
+{
+    unsigned char *bytearray = (unsigned char*)calloc((size_t)(size * size * 3), sizeof(unsigned char));
+    const int floor = mpfr->getMaxIter();
+
+    mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", mx, my);
+    for (int zoom = 0; zoom < zooms; zoom++) { mpfr->zoom_in(size, size); }
+    mpfr->setUsePerturbation(true);
+    mpfr->setTier(TIER_PERTURBATION);
+    mpfr->setMaxIter(maxiter);
+    for (int compressed = 0; compressed < 2; compressed++)
+    {
+        mpfr->setOrbitStorage(compressed ? ORBIT_STORAGE_COMPRESSED : ORBIT_STORAGE_FULL);
+        mpfr->mandelbrot_mpfr_c(size, size, &bytearray); // the orbit
+
+        const int frames = 3;
+        bench_clock::time_point start = bench_clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            mpfr->mandelbrot_mpfr_c(size, size, &bytearray);
+        }
+        printf("  %-10s %7u points %10zu bytes %10.2f us/frame\n", compressed ? "waypoints" : "full", 
+               mpfr->getOrbitLength(), mpfr->getOrbitBytes(), elapsed_us(start, frames));
+    }
+    mpfr->setOrbitStorage(ORBIT_STORAGE_AUTO);
+    mpfr->setMaxIter(floor);
+    mpfr->setTier(TIER_AUTO);
+    mpfr->setUsePerturbation(false);
+
+    free(bytearray);
+}
+
+// the orbit of c = i, 0, i, then -1+i, -i for ever
+static void orbit_of_i(const int n, double *Zr, double *Zi)
+{
+    if (n == 0) { *Zr = 0.0; *Zi = 0.0; }
+    else if (n == 1) { *Zr = 0.0; *Zi = 1.0; }
+    else if (n % 2 == 0) { *Zr = -1.0; *Zi = 1.0; }
+    else { *Zr = 0.0; *Zi = -1.0; }
+}
+
+// d = 2*Z*d + d^2 + dc along the orbit of i, in T
+template<typename T>
+static void delta_orbit(const T dcx, const T dcy, const int steps, T *dx, T *dy)
+{
+    T x = T(0), y = T(0);
+    for (int n = 0; n < steps; n++)
+    {
+        double Zr, Zi;
+        orbit_of_i(n, &Zr, &Zi);
+        T xtemp = T(2)*(T(Zr)*x - T(Zi)*y) + (x*x - y*y) + dcx;
+        y = T(2)*(T(Zr)*y + T(Zi)*x) + T(2)*x*y + dcy;
+        x = xtemp;
+    }
+    *dx = x;
+    *dy = y;
+}
+
+// the same in mpfr at bits
+static void delta_orbit_mpfr(mpfr_srcptr dcx, mpfr_srcptr dcy, const int steps, const int bits, mpfr_ptr dx, mpfr_ptr dy)
+{
+    mpfr_t x, y, t, u;
+    mpfr_inits2(bits, x, y, t, u, (mpfr_ptr)NULL);
+    mpfr_set_d(x, 0.0, MPFR_RNDN);
+    mpfr_set_d(y, 0.0, MPFR_RNDN);
+    for (int n = 0; n < steps; n++)
+    {
+        double Zr, Zi;
+        orbit_of_i(n, &Zr, &Zi);
+        mpfr_mul_d(t, x, Zr, MPFR_RNDN);     // t = 2*(Zr*x - Zi*y) + x*x - y*y + dcx
+        mpfr_mul_d(u, y, Zi, MPFR_RNDN);
+        mpfr_sub(t, t, u, MPFR_RNDN);
+        mpfr_mul_2ui(t, t, 1, MPFR_RNDN);
+        mpfr_sqr(u, x, MPFR_RNDN);
+        mpfr_add(t, t, u, MPFR_RNDN);
+        mpfr_sqr(u, y, MPFR_RNDN);
+        mpfr_sub(t, t, u, MPFR_RNDN);
+        mpfr_add(t, t, dcx, MPFR_RNDN);
+        mpfr_mul_d(u, y, Zr, MPFR_RNDN);     // y = 2*(Zr*y + Zi*x) + 2*x*y + dcy
+        mpfr_mul_d(y, y, 2.0, MPFR_RNDN);
+        mpfr_mul(y, y, x, MPFR_RNDN);
+        mpfr_mul_d(x, x, Zi, MPFR_RNDN);
+        mpfr_add(u, u, x, MPFR_RNDN);
+        mpfr_mul_2ui(u, u, 1, MPFR_RNDN);
+        mpfr_add(y, y, u, MPFR_RNDN);
+        mpfr_add(y, y, dcy, MPFR_RNDN);
+        mpfr_swap(x, t);
+    }
+    mpfr_set(dx, x, MPFR_RNDN);
+    mpfr_set(dy, y, MPFR_RNDN);
+    mpfr_clears(x, y, t, u, (mpfr_ptr)NULL);
+}
+
+/* ----------------------------------------------------------------------------
+ * a perturbation delta 1e-450 from c = i iterated 600 steps (to about 1e-220)
+ * in double, floatexp and 53 bit mpfr.  time per step, and the relative error
+ * of the result against 512 bit mpfr
+ */
+static void bench_floatexp(const int runs)
+{
+    const int steps = 600;
+    const long exp = -1500; // 2^-1500, about 1e-450
+    mpfr_t dcx, dcy, rx, ry, mx, my, err;
+    mpfr_inits2(512, dcx, dcy, rx, ry, mx, my, err, (mpfr_ptr)NULL);
+    mpfr_set_d(dcx, 0.6, MPFR_RNDN);
+    mpfr_mul_2si(dcx, dcx, exp, MPFR_RNDN);
+    mpfr_set_d(dcy, -0.7, MPFR_RNDN);
+    mpfr_mul_2si(dcy, dcy, exp, MPFR_RNDN);
+    delta_orbit_mpfr(dcx, dcy, steps, 512, rx, ry);
+
+    for (int type = 0; type < 3; type++)
+    {
+        const char *names[] = { "double", "floatexp", "mpfr 53" };
+        bench_clock::time_point start = bench_clock::now();
+        for (int run = 0; run < runs; run++)
+        {
+            if (type == 0) {
+                double x, y;
+                delta_orbit<double>(0.6 * ldexp(1.0, exp), -0.7 * ldexp(1.0, exp), steps, &x, &y);
+                mpfr_set_d(mx, x, MPFR_RNDN);
+                mpfr_set_d(my, y, MPFR_RNDN);
+            } else if (type == 1) {
+                floatexp x, y;
+                delta_orbit<floatexp>(floatexp(0.6, exp), floatexp(-0.7, exp), steps, &x, &y);
+                mpfr_set_d(mx, x.mantissa(), MPFR_RNDN);
+                mpfr_mul_2si(mx, mx, x.exponent(), MPFR_RNDN);
+                mpfr_set_d(my, y.mantissa(), MPFR_RNDN);
+                mpfr_mul_2si(my, my, y.exponent(), MPFR_RNDN);
+            } else {
+                delta_orbit_mpfr(dcx, dcy, steps, 53, mx, my);
+            }
+        }
+        double ns = elapsed_us(start, runs * steps) * 1000.0;
+
+        // |m - r| / |r| on the real part
+        mpfr_sub(err, mx, rx, MPFR_RNDN);
+        mpfr_div(err, err, rx, MPFR_RNDN);
+        printf("  %-10s %8.2f ns/step  rel error %.3g\n", names[type], ns, fabs(mpfr_get_d(err, MPFR_RNDN)));
+    }
+    mpfr_clears(dcx, dcy, rx, ry, mx, my, err, (mpfr_ptr)NULL);
+}
+
+int main(int argc, char *argv[])
+{
+    MandelbrotMpfr* mpfr = new MandelbrotMpfr(0, DEFAULT_MAXITER, 50);
+
+    printf("Frame dispatch overhead (%d threads)\n", mpfr->getNcpus());
+    bench_dispatch(mpfr->getNcpus(), 2000);
+
+    printf("Frame time (%s)\n", simd_level_name(mpfr->getSimdLevel()));
+    bench_frames(mpfr, 128, 5);
+
+    printf("Double tier kernels (%dx%d)\n", 512, 512);
+    bench_simd(mpfr, 512, 20);
+
+    printf("Deep frame (%dx%d, %d zooms)\n", 64, 64, 200);
+    bench_perturbation(mpfr, 64, 200);
+
+    printf("Past double range (%dx%d, %d zooms)\n", 32, 32, 1100);
+    bench_perturbation(mpfr, 32, 1100);
+
+    printf("Cardioid and bulb rejection (%dx%d)\n", 128, 128);
+    bench_bulbs(mpfr, 128);
+
+    printf("Periodicity checks on a minibrot (%dx%d, maxiter %d)\n", 32, 32, 10000);
+    bench_periodicity(mpfr, 32);
+
+    printf("Subdivision (%dx%d, %d zooms, maxiter 5000)\n", 64, 64, 40);
+    bench_subdivision(mpfr, 64, 40);
+
+    printf("MPFR loop (%dx%d, %d zooms)\n", 64, 64, 100);
+    bench_mpfr_loop(mpfr, 64);
+
+    printf("Fixed point against mpfr (%dx%d, %d zooms)\n", 64, 64, 150);
+    bench_fixed_point(mpfr, 64);
+
+    printf("Double-double and quad-double against mpfr (%dx%d)\n", 64, 64);
+    bench_multi_double(mpfr, 64);
+
+    printf("Fixed centre zoom (%dx%d, %d frames from %d zooms, maxiter 5000)\n", 32, 32, 20, 300);
+    bench_sequence(mpfr, 32, 300, 20);
+
+    printf("Reference orbit storage (%dx%d, %d zooms, maxiter %d)\n", 32, 32, 150, 200000);
+    bench_orbit_storage(mpfr, 32, "-1.7685736562998", "0.0", 150, 200000);
+    printf("Reference orbit storage (%dx%d, %d zooms, maxiter %d)\n", 32, 32, 30, 20000);
+    bench_orbit_storage(mpfr, 32, "-0.745118575346421375201", "0.131186393536551378392", 30, 20000);
+
+    printf("Perturbation delta arithmetic\n");
+    bench_floatexp(200);
+
+    printf("GMP/MPFR allocator (%dx%d)\n", 32, 32);
+    bench_allocator(mpfr, 32);
+
+    mpfr->free_mpfr_mem_c();
+    delete mpfr;
+
+    printf("Bench Complete\n");
+    return 0;
+}
@@ -3,12 +3,32 @@
  *
  * This is currently enough to provide over 99% branch coverage.
  * - use 'make coverage' to generate the results
- */ 
+ */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <atomic>
+#include <new>
+#include <filesystem>
 
-#include "mandelbrot.h"
+#include "MandelbrotMpfr.h"
+#include "FloatExp.h"
+#include "QuadDouble.h"
+
+/* count every C++ heap allocation (in this program and in libmandelbrot.so) */
+static std::atomic<unsigned long> glb_news(0);
+
+void* operator new(size_t size)
+{
+    glb_news++;
+    void* ptr = malloc(size);
+    if (ptr == NULL) { throw std::bad_alloc(); }
+    return ptr;
+}
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t size) noexcept { free(ptr); }
 
 int main(int argc, char *argv[])
 {
@@ -19,10 +39,10 @@ int main(int argc, char *argv[])
     factor = 50;
     maxiter = 1000;
 
-    printf("Testing setup_c\n");
-    setup_c();
+    printf("Testing MandelbrotMpfr\n");
+    MandelbrotMpfr* mpfr = new MandelbrotMpfr(0, maxiter, factor);
     printf("Testing initialize_c\n");
-    initialize_c("-2.0", "1.0", "-1.5", "1.5", "9.0", "9.0");
+    mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "9.0", "9.0");
 
     /* create an array of integers to store the result of the mandelbrot calculation */
     unsigned char *bytearray; /* [wsize * hsize * 3]; */
@@ -30,33 +50,814 @@ int main(int argc, char *argv[])
 
     /* call mandelbrot_mpfr_c */
     printf("Testing mandelbrot_mpfr_c\n");
-    mandelbrot_mpfr_c(wsize, hsize, maxiter, &bytearray);
+    mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
 
     printf("Testing mpfr_zoom_in\n");
-    mpfr_zoom_in_via_mouse(4, 4, wsize, hsize, factor);
-    mandelbrot_mpfr_c(wsize, hsize, maxiter, &bytearray);
+    mpfr->zoom_in_via_mouse(4, 4, wsize, hsize);
+    mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
 
     printf("Testing mpfr_zoom_out\n");
-    mpfr_zoom_out(/*4, 4, wsize, hsize,*/ factor);
-    mandelbrot_mpfr_c(wsize, hsize, maxiter, &bytearray);
+    mpfr->zoom_out();
+    mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
 
     printf("Testing mpfr_zoom_in\n");
-    mpfr_zoom_in_via_mouse(28, 28, wsize, hsize, factor);
-    mandelbrot_mpfr_c(wsize, hsize, maxiter, &bytearray);
+    mpfr->zoom_in_via_mouse(28, 28, wsize, hsize);
+    mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
 
     printf("Testing mpfr_zoom_out\n");
-    mpfr_zoom_out(/*4, 4, wsize, hsize,*/ 10);
-    mandelbrot_mpfr_c(wsize, hsize, maxiter, &bytearray);
+    mpfr->zoom_out();
+    mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+
+    printf("Testing repeated frames on the thread pool\n");
+    mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "0.0", "0.0");
+    for (int frame = 0; frame < 16; frame++)
+    {
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+    }
+
+    printf("Testing output does not depend on ncpus\n");
+    {
+        /* sizes that divide by neither the tile size nor the core count */
+        const unsigned int w = 40, h = 37;
+        unsigned char *single = (unsigned char*)calloc((size_t)(w * h * 3), sizeof(unsigned char));
+        unsigned char *multi = (unsigned char*)calloc((size_t)(w * h * 3), sizeof(unsigned char));
+
+        mpfr->setNcpus(1);
+        mpfr->mandelbrot_mpfr_c(w, h, &single);
+        mpfr->setNcpus(3);
+        mpfr->mandelbrot_mpfr_c(w, h, &multi);
+        assert(mpfr->getFrameAllocations() > 0); /* new worker state was built */
+        assert(memcmp(single, multi, (size_t)(w * h * 3)) == 0);
+
+        /* the last row (outside the set) must have been written */
+        unsigned int lit = 0;
+        for (unsigned int i = (h - 1) * w * 3; i < h * w * 3; i++) { lit += multi[i]; }
+        assert(lit > 0);
+
+        free(single);
+        free(multi);
+    }
+
+    printf("Testing steady state frames make no heap allocations\n");
+    {
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+        unsigned long news = glb_news;
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+        assert(mpfr->getFrameAllocations() == 0);
+        assert(glb_news == news);
+        mpfr->zoom_in_via_mouse(10, 20, wsize, hsize);
+        news = glb_news;
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+        assert(mpfr->getFrameAllocations() == 0);
+        assert(glb_news == news);
+
+        /* the fixed point kernels, scalar and vector, convert their mpfr inputs in per worker scratch */
+        mpfr->setTier(TIER_FIXED_POINT);
+        for (int level = SIMD_SCALAR; level <= simd_best_level(); level++)
+        {
+            mpfr->setSimdLevel((SimdLevel)level);
+            mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+            mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+            assert(mpfr->getFrameTier() == TIER_FIXED_POINT);
+            assert(mpfr->getFrameAllocations() == 0);
+        }
+        mpfr->setSimdLevel(simd_default_level());
+        mpfr->setTier(TIER_AUTO);
+
+        /* a subdivided frame reuses its counts and the deques have room for every split */
+        mpfr->setUseSubdivision(true);
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+        news = glb_news;
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+        assert(mpfr->getFrameAllocations() == 0);
+        assert(glb_news == news);
+        mpfr->setUseSubdivision(false);
+    }
+
+    printf("Testing per worker arenas give the same frame\n");
+    {
+        unsigned char *arena = (unsigned char*)calloc((size_t)(wsize * hsize * 3), sizeof(unsigned char));
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+        mpfr->setUseArena(true);
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &arena);
+        assert(memcmp(bytearray, arena, (size_t)(wsize * hsize * 3)) == 0);
+        mpfr->setUseArena(false);
+        free(arena);
+    }
+
+    printf("Testing precision follows the zoom depth\n");
+    {
+        /* c = i is a Misiurewicz point, there is detail around it at any depth */
+        mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "0.0", "1.0");
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+        int shallow = mpfr->getFramePrecision();
+        assert(shallow < DEFAULT_PRECISION);
+
+        /* 600 halvings puts the pixel spacing near 1e-190, past DEFAULT_PRECISION */
+        for (int zoom = 0; zoom < 600; zoom++) { mpfr->zoom_in(wsize, hsize); }
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+        assert(mpfr->getFramePrecision() > DEFAULT_PRECISION);
+
+        unsigned int differ = 0;
+        for (unsigned int i = 3; i < wsize * hsize * 3; i++) { differ += (bytearray[i] != bytearray[i % 3]); }
+        assert(differ > 0); /* has not bottomed out into a flat frame */
+    }
+
+    printf("Testing precision tiers hand off as the zoom deepens\n");
+    {
+        NumericTier last = TIER_AUTO;
+        bool seen_double = false, seen_dd = false, seen_qd = false;
+        mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "0.0", "1.0");
+        for (int zoom = 0; zoom < 220; zoom++)
+        {
+            mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+            assert(mpfr->getFrameTier() >= last);
+            last = mpfr->getFrameTier();
+            seen_double |= (last == TIER_DOUBLE);
+            seen_dd |= (last == TIER_DOUBLE_DOUBLE);
+            seen_qd |= (last == TIER_QUAD_DOUBLE);
+            mpfr->zoom_in(wsize, hsize);
+        }
+        assert(seen_double && seen_dd && seen_qd);
+        assert(last == TIER_MPFR);
+    }
+
+    printf("Testing double tier agrees with mpfr\n");
+    {
+        unsigned char *hardware = (unsigned char*)calloc((size_t)(wsize * hsize * 3), sizeof(unsigned char));
+        mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "0.0", "1.0");
+        for (int zoom = 0; zoom < 10; zoom++) { mpfr->zoom_in(wsize, hsize); }
+
+        mpfr->setTier(TIER_DOUBLE);
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &hardware);
+        mpfr->setTier(TIER_MPFR);
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+        mpfr->setTier(TIER_AUTO);
+
+        unsigned int same = 0;
+        for (unsigned int i = 0; i < wsize * hsize * 3; i += 3) { same += (memcmp(&hardware[i], &bytearray[i], 3) == 0); }
+        assert(same >= (wsize * hsize * 95) / 100);
+        free(hardware);
+    }
+
+    printf("Testing mpfr loop gives the same frame either side of the square cross term\n");
+    {
+        unsigned char *wide = (unsigned char*)calloc((size_t)(wsize * hsize * 3), sizeof(unsigned char));
+        const int floor = mpfr->getPrecision();
+        mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "0.0", "1.0");
+        for (int zoom = 0; zoom < 40; zoom++) { mpfr->zoom_in(wsize, hsize); }
+        mpfr->setTier(TIER_MPFR);
+        mpfr->setPrecision(MPFR_SQUARE_CROSS_BITS - 64);
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+        mpfr->setPrecision(MPFR_SQUARE_CROSS_BITS);
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &wide);
+        assert(mpfr->getFramePrecision() >= MPFR_SQUARE_CROSS_BITS);
+        mpfr->setPrecision(floor);
+        mpfr->setTier(TIER_AUTO);
+
+        unsigned int same = 0;
+        for (unsigned int i = 0; i < wsize * hsize * 3; i += 3) { same += (memcmp(&wide[i], &bytearray[i], 3) == 0); }
+        assert(same >= (wsize * hsize * 95) / 100);
+        free(wide);
+    }
+
+    printf("Testing fixed point tier agrees with mpfr\n");
+    {
+        unsigned char *fixed = (unsigned char*)calloc((size_t)(wsize * hsize * 3), sizeof(unsigned char));
+        /* 2 limbs up to 10 for 600 halvings, forced where auto could pick double-double */
+        const int depths[] = { 0, 80, 200, 600 };
+        int limbs = 0;
+
+        mpfr->setUseFixedPoint(true);
+        for (int depth : depths)
+        {
+            mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "0.0", "1.0");
+            for (int zoom = 0; zoom < depth; zoom++) { mpfr->zoom_in(wsize, hsize); }
+
+            mpfr->setTier(depth < 200 ? TIER_FIXED_POINT : TIER_AUTO);
+            mpfr->mandelbrot_mpfr_c(wsize, hsize, &fixed);
+            assert(mpfr->getFrameTier() == TIER_FIXED_POINT);
+            assert(mpfr->getFixedLimbs() == fixed_limbs(mpfr->getFramePrecision()));
+            assert(mpfr->getFixedLimbs() >= limbs);
+            limbs = mpfr->getFixedLimbs();
+            mpfr->setTier(TIER_MPFR);
+            mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+            assert(mpfr->getFixedLimbs() == 0);
+
+            unsigned int same = 0;
+            for (unsigned int i = 0; i < wsize * hsize * 3; i += 3) { same += (memcmp(&fixed[i], &bytearray[i], 3) == 0); }
+            printf("  depth %d: %u of %u pixels match (%d limbs)\n", depth, same, wsize * hsize, limbs);
+            assert(same >= (wsize * hsize * 95) / 100);
+        }
+        assert(limbs >= 10);
+
+        /* a view reaching past the integer bits, or more bits than the widest kernel, is left to mpfr */
+        mpfr->setTier(TIER_FIXED_POINT);
+        mpfr->initialize_c("-5.0", "1.0", "-1.5", "1.5", "0.0", "1.0");
+        mpfr->mandelbrot_mpfr_c(8, 8, &fixed);
+        assert(mpfr->getFrameTier() == TIER_MPFR);
+        const int floor = mpfr->getPrecision();
+        mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "0.0", "1.0");
+        mpfr->setPrecision(FIXED_MAX_LIMBS * 64 + 64);
+        mpfr->mandelbrot_mpfr_c(8, 8, &fixed);
+        assert(mpfr->getFrameTier() == TIER_MPFR);
+        assert(fixed_escape_row(FIXED_MAX_LIMBS + 1) == NULL);
+        mpfr->setPrecision(floor);
+        mpfr->setTier(TIER_AUTO);
+        mpfr->setUseFixedPoint(false);
+        free(fixed);
+    }
+
+    printf("Testing double-double and quad-double tiers agree with mpfr\n");
+    {
+        /* ten steps of z^2 + c against mpfr at 320 bits, from the values each type holds */
+        mpfr_t mx, my, mc, mt, err;
+        mpfr_inits2(320, mx, my, mc, mt, err, (mpfr_ptr)0);
+        auto set_parts = [](mpfr_ptr v, const double *parts, const int n) {
+            mpfr_set_d(v, parts[0], MPFR_RNDN);
+            for (int i = 1; i < n; i++) { mpfr_add_d(v, v, parts[i], MPFR_RNDN); }
+        };
+        auto iterate = [&]() {
+            for (int i = 0; i < 10; i++)
+            {
+                mpfr_sqr(mt, mx, MPFR_RNDN);
+                mpfr_sqr(err, my, MPFR_RNDN);
+                mpfr_sub(mt, mt, err, MPFR_RNDN);
+                mpfr_add(mt, mt, mc, MPFR_RNDN);
+                mpfr_mul(my, my, mx, MPFR_RNDN);
+                mpfr_mul_2ui(my, my, 1, MPFR_RNDN);
+                mpfr_add(my, my, mc, MPFR_RNDN);
+                mpfr_swap(mx, mt);
+            }
+        };
+
+        ddouble dx(0.1 / 3, 1e-18 / 7), dy(-0.2 / 7, 3e-19 / 11), dc(-0.583, 1e-17 / 13);
+        double parts[4];
+        parts[0] = dx.high(); parts[1] = dx.low(); set_parts(mx, parts, 2);
+        parts[0] = dy.high(); parts[1] = dy.low(); set_parts(my, parts, 2);
+        parts[0] = dc.high(); parts[1] = dc.low(); set_parts(mc, parts, 2);
+        for (int i = 0; i < 10; i++)
+        {
+            ddouble t = dx*dx - dy*dy + dc;
+            dy = ddouble(2)*dx*dy + dc;
+            dx = t;
+        }
+        iterate();
+        parts[0] = dx.high(); parts[1] = dx.low(); set_parts(mt, parts, 2);
+        mpfr_sub(err, mx, mt, MPFR_RNDN);
+        assert(mpfr_zero_p(err) || (mpfr_get_exp(err) < -DDOUBLE_MANT_DIG + 10));
+
+        qdouble qx(0.1 / 3, 1e-18 / 7, 1e-35 / 3, -1e-52 / 9), qy(-0.2 / 7, 3e-19 / 11, -1e-36 / 7, 1e-53 / 3),
+                qc(-0.583, 1e-17 / 13, 1e-34 / 11, 1e-51 / 7);
+        for (int i = 0; i < 4; i++) { parts[i] = qx[i]; } set_parts(mx, parts, 4);
+        for (int i = 0; i < 4; i++) { parts[i] = qy[i]; } set_parts(my, parts, 4);
+        for (int i = 0; i < 4; i++) { parts[i] = qc[i]; } set_parts(mc, parts, 4);
+        for (int i = 0; i < 10; i++)
+        {
+            qdouble t = qx*qx - qy*qy + qc;
+            qy = qdouble(2)*qx*qy + qc;
+            qx = t;
+        }
+        iterate();
+        for (int i = 0; i < 4; i++) { parts[i] = qx[i]; } set_parts(mt, parts, 4);
+        mpfr_sub(err, mx, mt, MPFR_RNDN);
+        assert(mpfr_zero_p(err) || (mpfr_get_exp(err) < -QDOUBLE_MANT_DIG + 10));
+        mpfr_clears(mx, my, mc, mt, err, (mpfr_ptr)0);
+
+        /* whole frames from about 1e-15 to 1e-60, in the tier auto picks */
+        unsigned char *multi = (unsigned char*)calloc((size_t)(wsize * hsize * 3), sizeof(unsigned char));
+        const int depths[] = { 50, 90, 130, 190 };
+        for (int depth : depths)
+        {
+            mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "0.0", "1.0");
+            for (int zoom = 0; zoom < depth; zoom++) { mpfr->zoom_in(wsize, hsize); }
+
+            mpfr->setTier(TIER_AUTO);
+            mpfr->mandelbrot_mpfr_c(wsize, hsize, &multi);
+            const NumericTier tier = mpfr->getFrameTier();
+            assert(tier == ((mpfr->getPixelBits() + TIER_GUARD_BITS <= DDOUBLE_MANT_DIG) ? TIER_DOUBLE_DOUBLE
+                                                                                         : TIER_QUAD_DOUBLE));
+            mpfr->setTier(TIER_MPFR);
+            mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+
+            unsigned int same = 0;
+            for (unsigned int i = 0; i < wsize * hsize * 3; i += 3) { same += (memcmp(&multi[i], &bytearray[i], 3) == 0); }
+            printf("  depth %d: %u of %u pixels match (%s)\n", depth, same, wsize * hsize, MandelbrotMpfr::tierName(tier));
+            assert(same >= (wsize * hsize * 95) / 100);
+        }
+        mpfr->setTier(TIER_AUTO);
+        free(multi);
+    }
+
+    printf("Testing main cardioid and bulb pixels are written without iterating\n");
+    {
+        unsigned char *iterated = (unsigned char*)calloc((size_t)(wsize * hsize * 3), sizeof(unsigned char));
+        const NumericTier tiers[] = { TIER_FLOAT, TIER_DOUBLE, TIER_LONG_DOUBLE, TIER_DOUBLE_DOUBLE, TIER_QUAD_DOUBLE,
+                                      TIER_FIXED_POINT, TIER_MPFR, TIER_PERTURBATION };
+        unsigned int rejected = 0;
+
+        mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "0.0", "1.0");
+        for (NumericTier tier : tiers)
+        {
+            mpfr->setTier(tier);
+            mpfr->setUseBulbRejection(false);
+            mpfr->mandelbrot_mpfr_c(wsize, hsize, &iterated);
+            assert(mpfr->getRejectedPixels() == 0);
+            mpfr->setUseBulbRejection(true);
+            mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+            assert(mpfr->getFrameTier() == tier);
+            /* every tier tests the same pixels the same way */
+            assert((rejected == 0) || (mpfr->getRejectedPixels() == rejected));
+            rejected = mpfr->getRejectedPixels();
+            assert(memcmp(iterated, bytearray, (size_t)(wsize * hsize * 3)) == 0);
+        }
+        /* about a quarter of the default view */
+        assert(rejected > (wsize * hsize) / 8);
+
+        /* a deep view on the boundary has none */
+        for (int zoom = 0; zoom < 40; zoom++) { mpfr->zoom_in(wsize, hsize); }
+        mpfr->setTier(TIER_AUTO);
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+        assert(mpfr->getRejectedPixels() == 0);
+        free(iterated);
+    }
+
+    printf("Testing periodicity checks classify interior orbits without changing the frame\n");
+    {
+        unsigned char *iterated = (unsigned char*)calloc((size_t)(wsize * hsize * 3), sizeof(unsigned char));
+        const NumericTier tiers[] = { TIER_FLOAT, TIER_DOUBLE, TIER_LONG_DOUBLE, TIER_DOUBLE_DOUBLE, TIER_QUAD_DOUBLE,
+                                      TIER_FIXED_POINT, TIER_MPFR };
+
+        /* the period 3 minibrot on the real axis, mostly interior */
+        mpfr->initialize_c("-1.7690", "-1.7400", "-0.0145", "0.0145", "0.0", "1.0");
+        mpfr->setMaxIter(4000);
+        for (NumericTier tier : tiers)
+        {
+            mpfr->setTier(tier);
+            mpfr->setUsePeriodicity(tier, false);
+            assert(!mpfr->getUsePeriodicity(tier));
+            mpfr->mandelbrot_mpfr_c(wsize, hsize, &iterated);
+            mpfr->setUsePeriodicity(tier, true);
+            mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+            assert(mpfr->getFrameTier() == tier);
+
+            /* the tolerance is under a pixel, an orbit that only lingers near a cycle can still be caught */
+            unsigned int same = 0;
+            for (unsigned int i = 0; i < wsize * hsize * 3; i += 3) { same += (memcmp(&iterated[i], &bytearray[i], 3) == 0); }
+            printf("  %s: %u of %u pixels match\n", MandelbrotMpfr::tierName(tier), same, wsize * hsize);
+            assert(same >= (wsize * hsize * 99) / 100);
+        }
+        mpfr->setUsePeriodicity(TIER_AUTO, false);
+        assert(!mpfr->getUsePeriodicity(TIER_DOUBLE) && !mpfr->getUsePeriodicity(TIER_MPFR));
+        mpfr->setUsePeriodicity(TIER_AUTO, true);
+        assert(mpfr->getUsePeriodicity(TIER_DOUBLE) && mpfr->getUsePeriodicity(TIER_MPFR));
+        mpfr->setMaxIter(maxiter);
+        mpfr->setTier(TIER_AUTO);
+        free(iterated);
+    }
+
+    printf("Testing subdivision fills uniform rectangles without changing the frame\n");
+    {
+        const unsigned int w = 64, h = 64;
+        const int cpus = mpfr->getNcpus();
+        unsigned char *whole = (unsigned char*)calloc((size_t)(w * h * 3), sizeof(unsigned char));
+        unsigned char *filled = (unsigned char*)calloc((size_t)(w * h * 3), sizeof(unsigned char));
+        unsigned char *threaded = (unsigned char*)calloc((size_t)(w * h * 3), sizeof(unsigned char));
+        const NumericTier tiers[] = { TIER_FLOAT, TIER_DOUBLE, TIER_LONG_DOUBLE, TIER_DOUBLE_DOUBLE,
+                                      TIER_FIXED_POINT, TIER_MPFR, TIER_PERTURBATION };
+        unsigned int most = 0;
+
+        /* the period 3 minibrot again, its interior is one large uniform region */
+        mpfr->initialize_c("-1.7690", "-1.7400", "-0.0145", "0.0145", "0.0", "1.0");
+        mpfr->setMaxIter(2000);
+        for (NumericTier tier : tiers)
+        {
+            mpfr->setTier(tier);
+            mpfr->setUseSubdivision(false);
+            mpfr->mandelbrot_mpfr_c(w, h, &whole);
+            assert(mpfr->getFilledPixels() == 0);
+            mpfr->setUseSubdivision(true);
+            assert(mpfr->getUseSubdivision());
+            mpfr->mandelbrot_mpfr_c(w, h, &filled);
+            assert(mpfr->getFrameTier() == tier);
+            assert(mpfr->getFilledPixels() > 0);
+
+            /* the quarters are scheduler tasks, how they are shared out can't change the frame */
+            mpfr->setNcpus(3);
+            mpfr->mandelbrot_mpfr_c(w, h, &threaded);
+            mpfr->setNcpus(cpus);
+            assert(memcmp(filled, threaded, w * h * 3) == 0);
+
+            /* a filament through a rectangle that misses its border is filled over */
+            unsigned int same = 0;
+            for (unsigned int i = 0; i < w * h * 3; i += 3) { same += (memcmp(&whole[i], &filled[i], 3) == 0); }
+            printf("  %s: %u of %u pixels match, %u filled\n", MandelbrotMpfr::tierName(tier), same, w * h,
+                   mpfr->getFilledPixels());
+            assert(same >= (w * h * 99) / 100);
+
+            /* rebased perturbation pixels have final counts, they mustn't stop a rectangle filling */
+            if (tier == TIER_PERTURBATION) {
+                assert(mpfr->getFilledPixels() >= most);
+            } else if (mpfr->getFilledPixels() > most) {
+                most = mpfr->getFilledPixels();
+            }
+        }
+        mpfr->setUseSubdivision(false);
+        mpfr->setMaxIter(maxiter);
+        mpfr->setTier(TIER_AUTO);
+        free(whole);
+        free(filled);
+        free(threaded);
+    }
+
+    printf("Testing vector fixed point kernels agree with the scalar one\n");
+    {
+        /* odd sizes leave part filled vectors at the end of every row */
+        const unsigned int w = 43, h = 21;
+        const int depths[] = { 0, 200, 600 };
+        unsigned char *scalar = (unsigned char*)calloc((size_t)(w * h * 3), sizeof(unsigned char));
+        unsigned char *vector = (unsigned char*)calloc((size_t)(w * h * 3), sizeof(unsigned char));
+        SimdLevel best = simd_best_level();
 
-    printf("Testing mandelbrot_mpfr_thread_c\n");
-    initialize_c("-2.0", "1.0", "-1.5", "1.5", "0.0", "0.0");
-    mandelbrot_mpfr_thread_c(wsize, hsize, maxiter, &bytearray);
+        mpfr->setTier(TIER_FIXED_POINT);
+        for (int depth : depths)
+        {
+            mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "0.0", "1.0");
+            for (int zoom = 0; zoom < depth; zoom++) { mpfr->zoom_in(w, h); }
+
+            mpfr->setSimdLevel(SIMD_SCALAR);
+            mpfr->mandelbrot_mpfr_c(w, h, &scalar);
+            for (int level = SIMD_AVX2; level <= best; level++)
+            {
+                mpfr->setSimdLevel((SimdLevel)level);
+                mpfr->mandelbrot_mpfr_c(w, h, &vector);
+                assert(mpfr->getFrameTier() == TIER_FIXED_POINT);
+
+                /* the two drop different bits, a pixel on the edge of escaping can differ */
+                unsigned int same = 0;
+                for (unsigned int i = 0; i < w * h * 3; i += 3) { same += (memcmp(&scalar[i], &vector[i], 3) == 0); }
+                printf("  depth %d %s: %u of %u pixels match\n", depth, simd_level_name((SimdLevel)level), same, w * h);
+                assert(same >= (w * h * 99) / 100);
+            }
+        }
+        mpfr->setTier(TIER_AUTO);
+        mpfr->setSimdLevel(simd_default_level());
+
+        free(scalar);
+        free(vector);
+    }
+
+    printf("Testing vector double kernels match the scalar one\n");
+    {
+        /* odd sizes leave part filled vectors at the end of every row */
+        const unsigned int w = 43, h = 21;
+        unsigned char *scalar = (unsigned char*)calloc((size_t)(w * h * 3), sizeof(unsigned char));
+        unsigned char *vector = (unsigned char*)calloc((size_t)(w * h * 3), sizeof(unsigned char));
+        SimdLevel best = simd_best_level();
+
+        mpfr->setTier(TIER_DOUBLE);
+        for (int view = 0; view < 2; view++)
+        {
+            /* the whole set (points out past |c| = 2), then a deep double frame */
+            mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "0.0", "1.0");
+            for (int zoom = 0; zoom < view * 30; zoom++) { mpfr->zoom_in(w, h); }
+
+            mpfr->setSimdLevel(SIMD_SCALAR);
+            mpfr->mandelbrot_mpfr_c(w, h, &scalar);
+            for (int level = SIMD_AVX2; level <= best; level++)
+            {
+                mpfr->setSimdLevel((SimdLevel)level);
+                assert(mpfr->getSimdLevel() == level);
+                mpfr->mandelbrot_mpfr_c(w, h, &vector);
+                assert(memcmp(scalar, vector, (size_t)(w * h * 3)) == 0);
+            }
+        }
+        mpfr->setTier(TIER_AUTO);
+        mpfr->setSimdLevel(SIMD_AVX512);
+        assert(mpfr->getSimdLevel() == best);
+
+        free(scalar);
+        free(vector);
+    }
+
+    printf("Testing MANDELBROT_SIMD forces the simd level\n");
+    {
+        setenv("MANDELBROT_SIMD", "scalar", 1);
+        MandelbrotMpfr* forced = new MandelbrotMpfr(0, maxiter, factor);
+        assert(forced->getSimdLevel() == SIMD_SCALAR);
+        delete forced;
+
+        /* anything the cpu can't run (or can't parse) leaves the best level */
+        setenv("MANDELBROT_SIMD", "sse9", 1);
+        assert(simd_default_level() == simd_best_level());
+        unsetenv("MANDELBROT_SIMD");
+        assert(simd_default_level() == simd_best_level());
+    }
+
+    printf("Testing perturbation agrees with mpfr\n");
+    {
+        unsigned char *perturbed = (unsigned char*)calloc((size_t)(wsize * hsize * 3), sizeof(unsigned char));
+        /* 1100 halvings is past 1e-330, below the smallest double */
+        const int depths[] = { 0, 80, 200, 1100 };
+
+        mpfr->setUsePerturbation(true);
+        for (int depth : depths)
+        {
+            mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "0.0", "1.0");
+            for (int zoom = 0; zoom < depth; zoom++) { mpfr->zoom_in(wsize, hsize); }
+
+            mpfr->setTier(depth == 0 ? TIER_PERTURBATION : TIER_AUTO);
+            mpfr->mandelbrot_mpfr_c(wsize, hsize, &perturbed);
+            assert(mpfr->getFrameTier() == ((depth < 1000) ? TIER_PERTURBATION : TIER_PERTURBATION_FLOATEXP));
+            assert(mpfr->getOrbitLength() >= 2);
+            unsigned int skip = mpfr->getSeriesSkip();
+            mpfr->setTier(TIER_MPFR);
+            mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+
+            unsigned int same = 0;
+            for (unsigned int i = 0; i < wsize * hsize * 3; i += 3) { same += (memcmp(&perturbed[i], &bytearray[i], 3) == 0); }
+            printf("  depth %d: %u of %u pixels match (series skip %u)\n", depth, same, wsize * hsize, skip);
+            assert(same >= (wsize * hsize * 95) / 100);
+        }
+        mpfr->setTier(TIER_AUTO);
+        mpfr->setUsePerturbation(false);
+        free(perturbed);
+    }
+
+    printf("Testing series approximation skips iterations without changing the frame\n");
+    {
+        unsigned char *series = (unsigned char*)calloc((size_t)(wsize * hsize * 3), sizeof(unsigned char));
+        mpfr->setUsePerturbation(true);
+        mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "0.0", "1.0");
+        for (int zoom = 0; zoom < 300; zoom++) { mpfr->zoom_in(wsize, hsize); }
+
+        mpfr->setUseSeries(false);
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+        assert(mpfr->getSeriesSkip() == 0 && mpfr->getSkippedIterations() == 0);
+        mpfr->setUseSeries(true);
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &series);
+        assert(mpfr->getSeriesSkip() > 100);
+        assert(mpfr->getSkippedIterations() == (unsigned long long)mpfr->getSeriesSkip() * wsize * hsize);
+
+        unsigned int same = 0;
+        for (unsigned int i = 0; i < wsize * hsize * 3; i += 3) { same += (memcmp(&series[i], &bytearray[i], 3) == 0); }
+        assert(same >= (wsize * hsize * 99) / 100);
+
+        mpfr->setUsePerturbation(false);
+        free(series);
+    }
+
+    printf("Testing BLA steps give the same frame within the memory cap\n");
+    {
+        unsigned char *bla = (unsigned char*)calloc((size_t)(wsize * hsize * 3), sizeof(unsigned char));
+        const int depths[] = { 300, 1100 };
+
+        mpfr->setUsePerturbation(true);
+        mpfr->setUseSeries(false);
+        for (int depth : depths)
+        {
+            mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "0.0", "1.0");
+            for (int zoom = 0; zoom < depth; zoom++) { mpfr->zoom_in(wsize, hsize); }
+            mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+            assert(mpfr->getBlaBytes() == 0);
+
+            /* the whole table, then one squeezed into 4KB (longer steps only) */
+            const size_t caps[] = { BLA_DEFAULT_CAP, 4096 };
+            for (size_t cap : caps)
+            {
+                mpfr->setUseBla(true);
+                mpfr->setBlaMemoryCap(cap);
+                mpfr->mandelbrot_mpfr_c(wsize, hsize, &bla);
+                assert(mpfr->getBlaBytes() > 0 && mpfr->getBlaBytes() <= cap);
+                mpfr->setUseBla(false);
+
+                unsigned int same = 0;
+                for (unsigned int i = 0; i < wsize * hsize * 3; i += 3) { same += (memcmp(&bla[i], &bytearray[i], 3) == 0); }
+                printf("  depth %d cap %zu: %u of %u pixels match\n", depth, cap, same, wsize * hsize);
+                assert(same >= (wsize * hsize * 99) / 100);
+            }
+        }
+        mpfr->setBlaMemoryCap(BLA_DEFAULT_CAP);
+        mpfr->setUseSeries(true);
+        mpfr->setUsePerturbation(false);
+        free(bla);
+    }
+
+    printf("Testing glitched pixels are found and corrected\n");
+    {
+        unsigned char *fixed = (unsigned char*)calloc((size_t)(wsize * hsize * 3), sizeof(unsigned char));
+        const GlitchMode modes[] = { GLITCH_NONE, GLITCH_REBASE, GLITCH_REFERENCES };
+
+        /* 3e-10 across a period 35 minibrot, the reference off to one side of it */
+        mpfr->initialize_c("-0.745118575496421375201", "-0.745118575196421375201", 
+                           "0.131186393386551378392", "0.131186393686551378392", 
+                           "-0.745118575481421375201", "0.131186393566551378392");
+        mpfr->setMaxIter(3000);
+        mpfr->setTier(TIER_MPFR);
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+        mpfr->setUsePerturbation(true);
+        mpfr->setTier(TIER_PERTURBATION);
+        for (GlitchMode mode : modes)
+        {
+            mpfr->setGlitchMode(mode);
+            mpfr->mandelbrot_mpfr_c(wsize, hsize, &fixed);
+
+            unsigned int same = 0;
+            for (unsigned int i = 0; i < wsize * hsize * 3; i += 3) { same += (memcmp(&fixed[i], &bytearray[i], 3) == 0); }
+            printf("  mode %d: %u of %u pixels match, %u glitched, %u references\n", mode, same, wsize * hsize, 
+                   mpfr->getGlitchedPixels(), mpfr->getGlitchReferences());
+            if (mode == GLITCH_NONE) {
+                assert(mpfr->getGlitchedPixels() == 0);
+                assert(same < (wsize * hsize * 99) / 100);
+            } else {
+                assert(mpfr->getGlitchedPixels() > 0 && mpfr->getUnresolvedGlitches() == 0);
+                assert(same >= (wsize * hsize * 995) / 1000);
+            }
+            if (mode == GLITCH_REFERENCES) {
+                /* only the glitched pixels were done again */
+                assert(mpfr->getGlitchReferences() > 0);
+                assert(mpfr->getGlitchedPixels() < wsize * hsize);
+            }
+        }
+        mpfr->setGlitchMode(GLITCH_REBASE);
+        mpfr->setTier(TIER_AUTO);
+        mpfr->setUsePerturbation(false);
+        mpfr->setMaxIter(maxiter);
+        free(fixed);
+    }
+
+    printf("Testing a fixed centre zoom reuses one reference orbit\n");
+    {
+        unsigned char *perturbed = (unsigned char*)calloc((size_t)(wsize * hsize * 3), sizeof(unsigned char));
+        const unsigned int zooms = 40;
+
+        mpfr->setUsePerturbation(true);
+        mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "0.0", "1.0");
+        for (int zoom = 0; zoom < 80; zoom++) { mpfr->zoom_in(wsize, hsize); }
+        mpfr->planZoomSequence(zooms, wsize);
+        assert(mpfr->getReferencePrecision() > mpfr->getFramePrecision());
+
+        /* computed once for the first frame, at the last frame's precision */
+        for (unsigned int frame = 0; frame <= zooms; frame++)
+        {
+            mpfr->mandelbrot_mpfr_c(wsize, hsize, &perturbed);
+            assert(mpfr->getFrameTier() == TIER_PERTURBATION);
+            assert(mpfr->getOrbitReused() == (frame > 0));
+            if (frame < zooms) { mpfr->zoom_in(wsize, hsize); }
+        }
+        assert(mpfr->getFramePrecision() == mpfr->getReferencePrecision());
+
+        mpfr->setTier(TIER_MPFR);
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+        mpfr->setTier(TIER_AUTO);
+        unsigned int same = 0;
+        for (unsigned int i = 0; i < wsize * hsize * 3; i += 3) { same += (memcmp(&perturbed[i], &bytearray[i], 3) == 0); }
+        assert(same == wsize * hsize);
+
+        /* more iterations carry the same orbit on */
+        mpfr->setMaxIter(2 * maxiter);
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &perturbed);
+        assert(mpfr->getOrbitReused() && mpfr->getOrbitLength() == 2 * maxiter + 1);
+
+        mpfr->setMaxIter(maxiter);
+        mpfr->setReferencePrecision(0);
+        mpfr->setUsePerturbation(false);
+        free(perturbed);
+    }
+
+    printf("Testing reference orbits are cached on disk\n");
+    {
+        unsigned char *cached = (unsigned char*)calloc((size_t)(wsize * hsize * 3), sizeof(unsigned char));
+        char dir[] = "/tmp/mandelbrot_orbits_XXXXXX";
+        assert(mkdtemp(dir) != NULL);
+
+        /* the first run computes and saves the orbit, the second loads it */
+        for (int run = 0; run < 2; run++)
+        {
+            MandelbrotMpfr* fresh = new MandelbrotMpfr(0, maxiter, factor);
+            fresh->setOrbitCache(dir);
+            fresh->setUsePerturbation(true);
+            fresh->initialize_c("-2.0", "1.0", "-1.5", "1.5", "0.0", "1.0");
+            for (int zoom = 0; zoom < 80; zoom++) { fresh->zoom_in(wsize, hsize); }
+            fresh->mandelbrot_mpfr_c(wsize, hsize, run ? &cached : &bytearray);
+            assert(fresh->getFrameTier() == TIER_PERTURBATION);
+            assert(fresh->getOrbitCached() == (run == 1));
+            assert(fresh->getOrbitCache()->bytes() > 0);
+
+            /* more iterations than were saved load it and carry it on */
+            if (run == 1) {
+                fresh->setReuseOrbit(false);
+                fresh->setMaxIter(2 * maxiter);
+                fresh->mandelbrot_mpfr_c(wsize, hsize, &cached);
+                assert(fresh->getOrbitCached() && fresh->getOrbitLength() == 2 * maxiter + 1);
+                fresh->setMaxIter(maxiter);
+                fresh->mandelbrot_mpfr_c(wsize, hsize, &cached);
+                assert(fresh->getOrbitCached() && fresh->getOrbitLength() == 2 * maxiter + 1);
+            }
+            fresh->free_mpfr_mem_c();
+            delete fresh;
+        }
+        assert(memcmp(cached, bytearray, wsize * hsize * 3) == 0);
+
+        /* a cache too small for two orbits keeps only the newest */
+        MandelbrotMpfr* small = new MandelbrotMpfr(0, maxiter, factor);
+        small->setOrbitCache(dir, 1);
+        small->setUsePerturbation(true);
+        small->initialize_c("-2.0", "1.0", "-1.5", "1.5", "-0.75", "0.1");
+        for (int zoom = 0; zoom < 80; zoom++) { small->zoom_in(wsize, hsize); }
+        small->mandelbrot_mpfr_c(wsize, hsize, &cached);
+        assert(!small->getOrbitCached());
+        unsigned int files = 0;
+        for (const auto &entry : std::filesystem::directory_iterator(dir)) { files++; (void)entry; }
+        assert(files == 1);
+        small->free_mpfr_mem_c();
+        delete small;
+
+        std::filesystem::remove_all(dir);
+        free(cached);
+    }
+
+    printf("Testing compressed reference orbits\n");
+    {
+        unsigned char *compressed = (unsigned char*)calloc((size_t)(wsize * hsize * 3), sizeof(unsigned char));
+        char dir[] = "/tmp/mandelbrot_orbits_XXXXXX";
+        assert(mkdtemp(dir) != NULL);
+
+        /* the period 35 minibrot of the glitch test, its orbit is far from periodic */
+        mpfr->initialize_c("-0.745118575496421375201", "-0.745118575196421375201", 
+                           "0.131186393386551378392", "0.131186393686551378392", 
+                           "-0.745118575346421375201", "0.131186393536551378392");
+        mpfr->setMaxIter(20000);
+        mpfr->setUsePerturbation(true);
+        mpfr->setTier(TIER_PERTURBATION);
+        mpfr->setOrbitStorage(ORBIT_STORAGE_FULL);
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+        const size_t full = mpfr->getOrbitBytes();
+        assert(!mpfr->getOrbitCompressed());
+
+        /* regenerated points are corrected to exactly the stored doubles, so the frame is too */
+        mpfr->setOrbitStorage(ORBIT_STORAGE_COMPRESSED);
+        mpfr->setOrbitCache(dir);
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &compressed);
+        assert(mpfr->getOrbitCompressed() && !mpfr->getOrbitCached());
+        printf("  orbit %zu bytes against %zu\n", mpfr->getOrbitBytes(), full);
+        assert(memcmp(compressed, bytearray, wsize * hsize * 3) == 0);
+        assert(mpfr->getOrbitBytes() * 4 < full);
+
+        /* saved and loaded as waypoints, the same frame again */
+        mpfr->setReuseOrbit(false);
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+        assert(mpfr->getOrbitCompressed() && mpfr->getOrbitCached());
+        assert(memcmp(compressed, bytearray, wsize * hsize * 3) == 0);
+
+        /* with BLA steps, which seek along the orbit, against BLA on the full orbit */
+        mpfr->setUseBla(true);
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &compressed);
+        mpfr->setOrbitStorage(ORBIT_STORAGE_FULL);
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+        assert(!mpfr->getOrbitCompressed());
+        assert(memcmp(compressed, bytearray, wsize * hsize * 3) == 0);
+
+        mpfr->setUseBla(false);
+        mpfr->setReuseOrbit(true);
+        mpfr->setOrbitCache("");
+        mpfr->setOrbitStorage(ORBIT_STORAGE_AUTO);
+        mpfr->setTier(TIER_AUTO);
+        mpfr->setUsePerturbation(false);
+        mpfr->setMaxIter(maxiter);
+        std::filesystem::remove_all(dir);
+        free(compressed);
+    }
+
+    printf("Testing floatexp rounds as double does\n");
+    {
+        assert((double)(floatexp(3.0) * floatexp(0.1)) == 3.0 * 0.1);
+        assert((double)(floatexp(1.0) + floatexp(1e-17)) == 1.0 + 1e-17);
+        assert((double)(floatexp(0.1) - floatexp(0.3)) == 0.1 - 0.3);
+        assert((double)floatexp(1.0, -2000) == 0.0);
+        assert((floatexp(1.0, -2000) * floatexp(1.0, 2000)).mantissa() == 0.5);
+        assert(floatexp(-1.0, -5000) < floatexp(1.0, -6000));
+        assert(floatexp(2.0, -5000) <= floatexp(4.0, -5001));
+
+        /* so a frame run in floatexp matches the double one pixel for pixel */
+        unsigned char *wide = (unsigned char*)calloc((size_t)(wsize * hsize * 3), sizeof(unsigned char));
+        mpfr->initialize_c("-2.0", "1.0", "-1.5", "1.5", "0.0", "1.0");
+        for (int zoom = 0; zoom < 80; zoom++) { mpfr->zoom_in(wsize, hsize); }
+        mpfr->setTier(TIER_PERTURBATION);
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &bytearray);
+        mpfr->setTier(TIER_PERTURBATION_FLOATEXP);
+        mpfr->mandelbrot_mpfr_c(wsize, hsize, &wide);
+        mpfr->setTier(TIER_AUTO);
+        assert(memcmp(bytearray, wide, (size_t)(wsize * hsize * 3)) == 0);
+        free(wide);
+    }
 
     printf("Testing mpfr_zoom_in\n");
-    mpfr_zoom_in_via_mouse(4, 4, wsize, hsize, factor);
-    
+    mpfr->zoom_in_via_mouse(4, 4, wsize, hsize);
+
     printf("Testing free_mpfr_mem_c\n");
-    free_mpfr_mem_c();
+    mpfr->free_mpfr_mem_c();
+    delete mpfr;
     free(bytearray);
 
     printf("Test Complete\n");